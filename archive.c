@@ -0,0 +1,274 @@
+#include "core.h"
+
+/*
+ * game archives:
+ *     ARCHIVE_MAGIC (8 bytes)
+ *     game records, back to back (each a multiple of 8 bytes long)
+ *     the index: the file offset of every record (unsigned long long each)
+ *     an ArchiveTrailer
+ * the trailer comes last so archives can be written in one pass;
+ * everything is 8 byte aligned, so records can be read in place from
+ * a mapped file. (numbers are stored in the machine's byte order.)
+ */
+#define ARCHIVE_MAGIC "CHSARC01"
+
+typedef struct _archiveTrailer {
+    unsigned long long indexOffset;
+    unsigned long long numGames;
+    char magic[8]; /* ARCHIVE_MAGIC again */
+} ArchiveTrailer;
+
+/* PackedPosition.flags */
+#define PACKED_BLACK_TO_MOVE 16 /* | castling rights */
+
+/*
+ * pack position:
+ * stores the position in gamePtr into *packedPtr
+ * (the halfmove clock is capped at 255)
+ *
+ * returns:
+ * FALSE if it has more than MAX_PACKED_PIECES pieces (*packedPtr is then cleared)
+ */
+int packPosition(GameState *gamePtr, PackedPosition *packedPtr) {
+    memset(packedPtr, 0, sizeof(PackedPosition));
+    if(__builtin_popcountll(gamePtr->occupied) > MAX_PACKED_PIECES)
+        return FALSE;
+    packedPtr->occupied = gamePtr->occupied;
+
+    /* one nibble per piece, in square order: color << 3 | type */
+    Bitboard pieces = gamePtr->occupied;
+    for(int i = 0; pieces; i++) {
+        int square = popLowestSquare(&pieces);
+        char piece = gamePtr->board[SQUARE_ROW(square)][SQUARE_COL(square)];
+        int code = pieceIsWhite(piece) << 3 | pieceType(piece);
+
+        packedPtr->pieces[i / 2] |= code << ((i % 2) * 4);
+    }
+
+    packedPtr->flags = gamePtr->castlingRights |
+                       (gamePtr->turn == BLACK ? PACKED_BLACK_TO_MOVE : 0);
+    packedPtr->enPassantSquare = gamePtr->enPassantSquare;
+    packedPtr->halfmoveClock = gamePtr->halfmoveClock < 255 ?
+                               gamePtr->halfmoveClock : 255;
+    packedPtr->fullmoveNumber = gamePtr->fullmoveNumber;
+    return TRUE;
+}
+
+/*
+ * unpack position:
+ * sets up gamePtr from a packed position
+ *
+ * returns:
+ * TRUE if it holds a valid, legal position (see positionIsLegal),
+ * FALSE otherwise (gamePtr is then undefined)
+ */
+int unpackPosition(GameState *gamePtr, const PackedPosition *packedPtr) {
+    memset(gamePtr, 0, sizeof(GameState));
+    memset(gamePtr->board, ' ', sizeof(gamePtr->board));
+
+    Bitboard pieces = packedPtr->occupied;
+    if(__builtin_popcountll(pieces) > MAX_PACKED_PIECES)
+        return FALSE;
+
+    for(int i = 0; pieces; i++) {
+        int square = popLowestSquare(&pieces);
+        int code = (packedPtr->pieces[i / 2] >> ((i % 2) * 4)) & 15;
+        if((code & 7) > KING)
+            return FALSE;
+
+        setSquare(gamePtr, SQUARE_ROW(square), SQUARE_COL(square),
+                  pieceChar(code & 7, code >> 3));
+    }
+
+    gamePtr->turn = (packedPtr->flags & PACKED_BLACK_TO_MOVE) ? BLACK : WHITE;
+    if(!positionIsLegal(gamePtr))
+        return FALSE;
+    gamePtr->castlingRights = packedPtr->flags & ALL_CASTLING_RIGHTS;
+    gamePtr->enPassantSquare = packedPtr->enPassantSquare;
+    if(gamePtr->enPassantSquare > NO_SQUARE)
+        return FALSE;
+    gamePtr->halfmoveClock = packedPtr->halfmoveClock;
+    gamePtr->fullmoveNumber = packedPtr->fullmoveNumber;
+
+    /* setSquare has hashed the pieces already */
+    gamePtr->hash ^= castlingKeys[gamePtr->castlingRights];
+    if(gamePtr->enPassantSquare != NO_SQUARE)
+        gamePtr->hash ^= enPassantKeys[SQUARE_COL(gamePtr->enPassantSquare)];
+    if(gamePtr->turn == BLACK)
+        gamePtr->hash ^= blackToMoveKey;
+
+    return TRUE;
+}
+
+/*
+ * the size of a game record of numMoves moves (padded to 8 bytes)
+ */
+long long gameRecordSize(int numMoves) {
+    return (offsetof(GameRecord, moves) + numMoves * sizeof(Move) + 7) & ~7LL;
+}
+
+/*
+ * appends a game record (its starting position, numMoves moves and
+ * result, one of the GAME_RESULT values) to bufferPtr.
+ * runs of records built this way are written with writeGameRecords.
+ */
+void appendGameRecord(TextBuffer *bufferPtr, const PackedPosition *startPtr,
+                      const Move *moves, int numMoves, int result) {
+    static const char padding[8];
+    long long headerSize = offsetof(GameRecord, moves);
+    long long movesSize = numMoves * sizeof(Move);
+
+    GameRecord header;
+    memset(&header, 0, sizeof(header));
+    header.start = *startPtr;
+    header.numMoves = numMoves;
+    header.result = result;
+
+    appendText(bufferPtr, (const char *) &header, headerSize);
+    appendText(bufferPtr, (const char *) moves, movesSize);
+    appendText(bufferPtr, padding, gameRecordSize(numMoves) - headerSize - movesSize);
+}
+
+/*
+ * create archive:
+ * starts a new archive at path.
+ *
+ * returns:
+ * FALSE if the file could not be created
+ */
+int createArchive(ArchiveWriter *writerPtr, const char *path) {
+    writerPtr->file = fopen(path, "wb");
+    if(writerPtr->file == NULL)
+        return FALSE;
+
+    writerPtr->offset = sizeof(ARCHIVE_MAGIC) - 1;
+    writerPtr->numGames = 0;
+    writerPtr->indexCapacity = 1024;
+    writerPtr->index = malloc(writerPtr->indexCapacity * sizeof(unsigned long long));
+
+    fwrite(ARCHIVE_MAGIC, 1, sizeof(ARCHIVE_MAGIC) - 1, writerPtr->file);
+    return TRUE;
+}
+
+/*
+ * writes a run of game records (built with appendGameRecord)
+ * to the archive, indexing each one
+ */
+void writeGameRecords(ArchiveWriter *writerPtr, const char *records,
+                      long long length) {
+    for(long long i = 0; i < length;) {
+        const GameRecord *recordPtr = (const GameRecord *) (records + i);
+
+        if(writerPtr->numGames == writerPtr->indexCapacity) {
+            writerPtr->indexCapacity *= 2;
+            writerPtr->index = realloc(writerPtr->index,
+                writerPtr->indexCapacity * sizeof(unsigned long long));
+        }
+        writerPtr->index[writerPtr->numGames++] = writerPtr->offset + i;
+
+        i += gameRecordSize(recordPtr->numMoves);
+    }
+
+    fwrite(records, 1, length, writerPtr->file);
+    writerPtr->offset += length;
+}
+
+/*
+ * finish archive:
+ * writes the index and trailer, and closes the archive
+ *
+ * returns:
+ * FALSE if it could not all be written
+ */
+int finishArchive(ArchiveWriter *writerPtr) {
+    ArchiveTrailer trailer;
+    trailer.indexOffset = writerPtr->offset;
+    trailer.numGames = writerPtr->numGames;
+    memcpy(trailer.magic, ARCHIVE_MAGIC, sizeof(trailer.magic));
+
+    fwrite(writerPtr->index, sizeof(unsigned long long), writerPtr->numGames,
+           writerPtr->file);
+    fwrite(&trailer, sizeof(trailer), 1, writerPtr->file);
+    free(writerPtr->index);
+
+    int failed = ferror(writerPtr->file);
+    return fclose(writerPtr->file) == 0 && !failed;
+}
+
+/*
+ * does every entry of an archive's index point at a whole, aligned
+ * record between the magic and the index (indexOffset) ?
+ */
+int archiveIndexIsValid(const MappedFile *filePtr, const unsigned long long *index,
+                        unsigned long long numGames, unsigned long long indexOffset) {
+    unsigned long long magicLength = sizeof(ARCHIVE_MAGIC) - 1;
+
+    for(unsigned long long i = 0; i < numGames; i++) {
+        unsigned long long offset = index[i];
+        if(offset < magicLength || offset % 8 != 0 ||
+           offset > indexOffset || indexOffset - offset < sizeof(GameRecord))
+            return FALSE;
+
+        const GameRecord *recordPtr = (const GameRecord *) (filePtr->data + offset);
+        if((unsigned long long) gameRecordSize(recordPtr->numMoves) > indexOffset - offset)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * open archive:
+ * maps the archive at path into memory, for archiveGame.
+ * the index is checked here, so archiveGame can trust it.
+ *
+ * returns:
+ * FALSE if it could not be read, or is not an archive
+ */
+int openArchive(Archive *archivePtr, const char *path) {
+    MappedFile *filePtr = &archivePtr->file;
+    if(!mapFile(filePtr, path))
+        return FALSE;
+
+    long long magicLength = sizeof(ARCHIVE_MAGIC) - 1;
+    if(filePtr->length < magicLength + (long long) sizeof(ArchiveTrailer) ||
+       memcmp(filePtr->data, ARCHIVE_MAGIC, magicLength) != 0) {
+        unmapFile(filePtr);
+        return FALSE;
+    }
+
+    const ArchiveTrailer *trailerPtr = (const ArchiveTrailer *)
+        (filePtr->data + filePtr->length - sizeof(ArchiveTrailer));
+    /* checked so that nothing can overflow: the index ends at the trailer */
+    unsigned long long trailerOffset = filePtr->length - sizeof(ArchiveTrailer);
+    unsigned long long maxGames = trailerOffset / sizeof(unsigned long long);
+    unsigned long long indexLength = trailerPtr->numGames * sizeof(unsigned long long);
+    if(memcmp(trailerPtr->magic, ARCHIVE_MAGIC, magicLength) != 0 ||
+       trailerPtr->numGames > maxGames || trailerPtr->indexOffset % 8 != 0 ||
+       trailerPtr->indexOffset != trailerOffset - indexLength) {
+        unmapFile(filePtr);
+        return FALSE;
+    }
+
+    const unsigned long long *index = (const unsigned long long *)
+                                      (filePtr->data + trailerPtr->indexOffset);
+    if(!archiveIndexIsValid(filePtr, index, trailerPtr->numGames, 
+                            trailerPtr->indexOffset)) {
+        unmapFile(filePtr);
+        return FALSE;
+    }
+
+    archivePtr->numGames = trailerPtr->numGames;
+    archivePtr->index = index;
+    return TRUE;
+}
+
+/*
+ * the record of game number gameIndex (from 0), read in place
+ */
+const GameRecord *archiveGame(Archive *archivePtr, long long gameIndex) {
+    return (const GameRecord *) (archivePtr->file.data + archivePtr->index[gameIndex]);
+}
+
+void closeArchive(Archive *archivePtr) {
+    unmapFile(&archivePtr->file);
+}
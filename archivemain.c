@@ -0,0 +1,82 @@
+#include "core.h"
+
+/*
+ * prints game number gameIndex of the archive: its starting position,
+ * moves, result and final position, checking every move on the way
+ *
+ * returns:
+ * FALSE if the record is not a valid game
+ */
+int printGame(Archive *archivePtr, long long gameIndex) {
+    static const char *results[] = {"*", "1-0", "0-1", "1/2-1/2"};
+    const GameRecord *recordPtr = archiveGame(archivePtr, gameIndex);
+    GameState game;
+    char fen[MAX_FEN_LENGTH];
+
+    if(!unpackPosition(&game, &recordPtr->start) || recordPtr->result > GAME_RESULT_DRAW) {
+        printf("game %lld: invalid record\n", gameIndex);
+        return FALSE;
+    }
+
+    writeFen(&game, fen);
+    printf("game %lld: %d plies, %s\nstart: %s\nmoves:", gameIndex,
+           recordPtr->numMoves, results[recordPtr->result], fen);
+
+    for(int i = 0; i < recordPtr->numMoves; i++) {
+        Move move = recordPtr->moves[i];
+        char moveStr[6];
+        moveToString(move, moveStr);
+        printf(" %s", moveStr);
+
+        if(!moveIsLegal(&game, move)) {
+            printf(" (illegal)\n");
+            return FALSE;
+        }
+        makeMove(&game, move, NULL);
+    }
+
+    writeFen(&game, fen);
+    printf("\nfinal: %s\n", fen);
+    return TRUE;
+}
+
+/*
+ * usage:
+ *     archive <file>            print the number of games in an archive
+ *     archive <file> <n> [m]    print games n to m (from 0)
+ */
+int main(int argc, char **argv) {
+    initEvalTables();
+
+    if(argc < 2 || argc > 4) {
+        printf("usage: archive <file> [n [m]]\n");
+        return 1;
+    }
+
+    Archive archive;
+    if(!openArchive(&archive, argv[1])) {
+        printf("%s is not a readable archive\n", argv[1]);
+        return 1;
+    }
+
+    if(argc == 2) {
+        printf("%lld games\n", archive.numGames);
+        closeArchive(&archive);
+        return 0;
+    }
+
+    long long first = atoll(argv[2]);
+    long long last = (argc == 4) ? atoll(argv[3]) : first;
+    if(first < 0 || last >= archive.numGames || first > last) {
+        printf("%s has games 0 to %lld\n", argv[1], archive.numGames - 1);
+        closeArchive(&archive);
+        return 1;
+    }
+
+    int valid = TRUE;
+    for(long long i = first; i <= last; i++)
+        valid &= printGame(&archive, i);
+
+    closeArchive(&archive);
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+#include "core.h"
+
+#define MAX_RESULT_LENGTH 4096 /* the results for one position */
+
+/*
+ * what to work out for each position, besides its legal moves and status
+ */
+typedef struct _batchOptions {
+    int perftDepth; /* 0 for no perft count */
+    int searchDepth; /* 0 for no search */
+} BatchOptions;
+
+/*
+ * writes the results for the position on one line of input into result:
+ *     <fen>; status <status>; legal <n> <moves...>
+ *     [; perft <nodes>] [; bestmove <move> score <centipawns>]
+ * where status is one of (see statusName): ongoing, checkmate, stalemate,
+ * fifty-move rule, threefold repetition, insufficient material
+ * (a single position has no history, so the repetition draw never appears)
+ * or <line>; error invalid fen
+ * line is lineLength chars long, and ends in whitespace (not part of it).
+ *
+ * returns:
+ * the length of result
+ */
+int analyzePosition(BatchOptions *optionsPtr, const char *line, int lineLength,
+                    char *result) {
+    GameState game;
+    int length = 0;
+
+    if(lineLength > MAX_FEN_LENGTH || parseFen(&game, line) == NULL) {
+        if(lineLength > MAX_FEN_LENGTH)
+            lineLength = MAX_FEN_LENGTH;
+        return sprintf(result, "%.*s; error invalid fen\n", lineLength, line);
+    }
+
+    MoveList legalMoves;
+    int numMoves = getAllLegalMoves(&game, &legalMoves, game.turn);
+    int status = (numMoves > 0) ? drawStatus(&game, NULL) : gameStatus(&game, NULL);
+
+    length += sprintf(result + length, "%.*s; status %s; legal %d", lineLength, line,
+                      statusName(status), numMoves);
+    for(int i = 0; i < numMoves; i++) {
+        result[length++] = ' ';
+        moveToString(legalMoves.moves[i], result + length);
+        length += strlen(result + length);
+    }
+
+    if(optionsPtr->perftDepth > 0) {
+        length += sprintf(result + length, "; perft %lld",
+                          perft(&game, optionsPtr->perftDepth));
+    }
+
+    if(optionsPtr->searchDepth > 0 && numMoves > 0) {
+        SearchLimits limits = {.maxDepth = optionsPtr->searchDepth, .stopPtr = NULL};
+        SearchResult searchResult;
+        char moveStr[6];
+        searchBestMove(&game, NULL, NULL, &limits, &searchResult);
+        moveToString(searchResult.bestMove, moveStr);
+        length += sprintf(result + length, "; bestmove %s score %d",
+                          moveStr, searchResult.score);
+    }
+
+    result[length++] = '\n';
+    return length;
+}
+
+/*
+ * analyzes every line of input into outputPtr
+ * (blank lines are skipped)
+ */
+void analyzeLines(void *context, const char *input, long long length, 
+                  long long offset, TextBuffer *outputPtr) {
+    BatchOptions *optionsPtr = context;
+    char result[MAX_RESULT_LENGTH];
+    const char *line = input;
+    (void) offset; /* each line stands alone, wherever its chunk started */
+    const char *end = input + length;
+
+    while(line < end) {
+        const char *lineEnd = memchr(line, '\n', end - line);
+        char lastLine[MAX_FEN_LENGTH + 2];
+
+        if(lineEnd == NULL) {
+            /*
+             * the last line of the input has no newline, and a mapped file
+             * has no '\0' after it, so the parser gets a terminated copy
+             */
+            int lastLength = end - line;
+            if(lastLength > MAX_FEN_LENGTH + 1)
+                lastLength = MAX_FEN_LENGTH + 1;
+            memcpy(lastLine, line, lastLength);
+            lastLine[lastLength] = '\0';
+
+            line = lastLine;
+            lineEnd = lastLine + lastLength;
+            end = lineEnd;
+        }
+
+        /* trim the line, which may end in "\r" */
+        const char *next = lineEnd + 1;
+        while(line < lineEnd && isspace((unsigned char) *line))
+            line++;
+        while(lineEnd > line && isspace((unsigned char) lineEnd[-1]))
+            lineEnd--;
+
+        if(lineEnd > line) {
+            int resultLength = analyzePosition(optionsPtr, line, lineEnd - line, result);
+            appendText(outputPtr, result, resultLength);
+        }
+
+        line = next;
+    }
+}
+
+/*
+ * usage:
+ *     batch [options] [file]    analyze one fen per line of file (default: stdin)
+ * options:
+ *     -threads <n>    analyze on n threads (default: one per processor)
+ *     -perft <depth>  also count the move tree to depth
+ *     -depth <n>      also search n plies for the best move
+ */
+int main(int argc, char **argv) {
+    initEvalTables();
+
+    BatchOptions options = {0, 0};
+    int numThreads = processorCount();
+
+    int argIndex = 1;
+    while(argIndex + 1 < argc) {
+        if(strcmp(argv[argIndex], "-threads") == 0) {
+            numThreads = atoi(argv[argIndex + 1]);
+            if(numThreads < 1)
+                numThreads = 1;
+        } else if(strcmp(argv[argIndex], "-perft") == 0) {
+            options.perftDepth = atoi(argv[argIndex + 1]);
+        } else if(strcmp(argv[argIndex], "-depth") == 0) {
+            options.searchDepth = atoi(argv[argIndex + 1]);
+        } else {
+            break;
+        }
+        argIndex += 2;
+    }
+
+    if(argIndex + 1 < argc || (argIndex < argc && argv[argIndex][0] == '-' &&
+                               argv[argIndex][1] != '\0')) {
+        printf("usage: batch [-threads n] [-perft depth] [-depth n] [file]\n");
+        return 1;
+    }
+
+    /* "-" (or no file) is stdin */
+    const char *path = (argIndex < argc && strcmp(argv[argIndex], "-") != 0) ?
+                       argv[argIndex] : NULL;
+
+    PipelineHandlers handlers = {lastLineEnd, analyzeLines, NULL, &options};
+    if(!runPipeline(path, &handlers, numThreads)) {
+        fprintf(stderr, "could not read %s\n", path);
+        return 1;
+    }
+    return 0;
+}
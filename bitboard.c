@@ -0,0 +1,159 @@
+#include "core.h"
+
+/*
+ * piece type:
+ * returns PAWN, KNIGHT, BISHOP, ROOK, QUEEN or KING
+ * for a piece char of either color (NO_PIECE for ' ')
+ */
+int pieceType(char piece) {
+    switch(piece) {
+        case 'p': case 'P':
+            return PAWN;
+        case 'n': case 'N':
+            return KNIGHT;
+        case 'b': case 'B':
+            return BISHOP;
+        case 'r': case 'R':
+            return ROOK;
+        case 'q': case 'Q':
+            return QUEEN;
+        case 'k': case 'K':
+            return KING;
+    }
+    return NO_PIECE;
+}
+
+/*
+ * piece char:
+ * returns the char for a piece type of the given color
+ * (uppercase for white)
+ */
+char pieceChar(int type, int color) {
+    static char whitePieces[] = "PNBRQK";
+    static char blackPieces[] = "pnbrqk";
+
+    return (color == WHITE) ? whitePieces[type] : blackPieces[type];
+}
+
+/*
+ * places piece (or ' ') on the board at row, col,
+ * updating the bitboards, hash and evaluation to match.
+ */
+void setSquare(GameState *gamePtr, int row, int col, char piece) {
+    Bitboard bit = SQUARE_BIT(SQUARE(row, col));
+    char oldPiece = gamePtr->board[row][col];
+
+    if(oldPiece != ' ') {
+        int color = pieceIsWhite(oldPiece);
+        int type = pieceType(oldPiece);
+        gamePtr->pieceBoards[color][type] &= ~bit;
+        gamePtr->colorBoards[color] &= ~bit;
+        gamePtr->occupied &= ~bit;
+        gamePtr->hash ^= pieceKeys[color][type][SQUARE(row, col)];
+        gamePtr->middlegameScore -= middlegameValues[color][type][SQUARE(row, col)];
+        gamePtr->endgameScore -= endgameValues[color][type][SQUARE(row, col)];
+        gamePtr->phase -= phaseValues[type];
+    }
+
+    if(piece != ' ') {
+        int color = pieceIsWhite(piece);
+        int type = pieceType(piece);
+        gamePtr->pieceBoards[color][type] |= bit;
+        gamePtr->colorBoards[color] |= bit;
+        gamePtr->occupied |= bit;
+        gamePtr->hash ^= pieceKeys[color][type][SQUARE(row, col)];
+        gamePtr->middlegameScore += middlegameValues[color][type][SQUARE(row, col)];
+        gamePtr->endgameScore += endgameValues[color][type][SQUARE(row, col)];
+        gamePtr->phase += phaseValues[type];
+    }
+
+    gamePtr->board[row][col] = piece;
+}
+
+/*
+ * rebuilds every bitboard and the evaluation from gamePtr->board
+ * (gamePtr->hash must be recomputed afterwards)
+ */
+void syncBitboards(GameState *gamePtr) {
+    memset(gamePtr->pieceBoards, 0, sizeof(gamePtr->pieceBoards));
+    memset(gamePtr->colorBoards, 0, sizeof(gamePtr->colorBoards));
+    gamePtr->occupied = 0;
+    gamePtr->middlegameScore = 0;
+    gamePtr->endgameScore = 0;
+    gamePtr->phase = 0;
+
+    for(int row = 0; row < 8; row++) {
+        for(int col = 0; col < 8; col++) {
+            char piece = gamePtr->board[row][col];
+            gamePtr->board[row][col] = ' ';
+            setSquare(gamePtr, row, col, piece);
+        }
+    }
+}
+
+/*
+ * removes the lowest set bit from *bitboardPtr,
+ * and returns its square number.
+ * (*bitboardPtr must not be empty)
+ */
+int popLowestSquare(Bitboard *bitboardPtr) {
+    int square = __builtin_ctzll(*bitboardPtr);
+    *bitboardPtr &= *bitboardPtr - 1;
+
+    return square;
+}
+
+/*
+ * squares a knight on square attacks
+ */
+Bitboard knightAttacks(int square) {
+    return knightAttackTable[square];
+}
+
+/*
+ * squares a king on square attacks
+ */
+Bitboard kingAttacks(int square) {
+    return kingAttackTable[square];
+}
+
+/*
+ * squares a pawn of color on square attacks (diagonally)
+ */
+Bitboard pawnAttacks(int square, int color) {
+    return pawnAttackTable[color][square];
+}
+
+/*
+ * squares a rook on square attacks, given the occupied squares
+ */
+Bitboard rookAttacks(int square, Bitboard occupied) {
+    const Magic *magicPtr = &rookMagics[square];
+    return magicPtr->attacks[((occupied & magicPtr->mask) * magicPtr->magic) >> 
+                             magicPtr->shift];
+}
+
+/*
+ * squares a bishop on square attacks, given the occupied squares
+ */
+Bitboard bishopAttacks(int square, Bitboard occupied) {
+    const Magic *magicPtr = &bishopMagics[square];
+    return magicPtr->attacks[((occupied & magicPtr->mask) * magicPtr->magic) >> 
+                             magicPtr->shift];
+}
+
+/*
+ * squares strictly between a and b
+ * (empty if they are not on a common row, column or diagonal)
+ */
+Bitboard squaresBetween(int a, int b) {
+    return betweenTable[a][b];
+}
+
+/*
+ * every square on the line through a and b, edge to edge
+ * (empty if they are not on a common row, column or diagonal)
+ */
+Bitboard lineThrough(int a, int b) {
+    return lineTable[a][b];
+}
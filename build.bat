@@ -1 +1,11 @@
-gcc chess.c game.c printing.c prompts.c moves.c
+gcc -O2 gentables.c -o gentables
+gentables > tables.c
+gcc -O2 -c game.c moves.c bitboard.c zobrist.c fen.c eval.c search.c tt.c thread.c perft.c pipeline.c san.c archive.c gamepool.c tables.c
+ar rcs libchess.a game.o moves.o bitboard.o zobrist.o fen.o eval.o search.o tt.o thread.o perft.o pipeline.o san.o archive.o gamepool.o tables.o
+gcc -O2 chess.c printing.c prompts.c libchess.a -o chess
+gcc -O2 perftmain.c libchess.a -o perft
+gcc -O2 batchmain.c libchess.a -o batch
+gcc -O2 pgnmain.c libchess.a -o pgn
+gcc -O2 archivemain.c libchess.a -o archive
+gcc -O2 ucimain.c libchess.a -o uci
+gcc -O2 servermain.c libchess.a -o server -lws2_32
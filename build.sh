@@ -0,0 +1,13 @@
+#!/bin/sh
+set -e
+gcc -O2 gentables.c -o gentables
+./gentables > tables.c
+gcc -O2 -c game.c moves.c bitboard.c zobrist.c fen.c eval.c search.c tt.c thread.c perft.c pipeline.c san.c archive.c gamepool.c tables.c
+ar rcs libchess.a game.o moves.o bitboard.o zobrist.o fen.o eval.o search.o tt.o thread.o perft.o pipeline.o san.o archive.o gamepool.o tables.o
+gcc -O2 chess.c printing.c prompts.c libchess.a -o chess -lpthread
+gcc -O2 perftmain.c libchess.a -o perft -lpthread
+gcc -O2 batchmain.c libchess.a -o batch -lpthread
+gcc -O2 pgnmain.c libchess.a -o pgn -lpthread
+gcc -O2 archivemain.c libchess.a -o archive -lpthread
+gcc -O2 ucimain.c libchess.a -o uci -lpthread
+gcc -O2 servermain.c libchess.a -o server -lpthread
@@ -1,63 +1,179 @@
-#include "chess.h"
-
-
-/*
- * copies one board to another
- */
-void boardCopy(char boardDest[8][8], char boardSource[8][8]) {
-    for(int row = 0; row < 8; row++) {
-        for(int col = 0; col < 8; col++) {
-            boardDest[row][col] = boardSource[row][col];
-        }
-    }
-}
-
-/*
- * sets the fields of a new GameState based on default values
- * and user input.
- */
-GameState *initNewGame() {
-    GameState *gamePtr = malloc(sizeof(GameState));
-
-    /* init game's members */
-    gamePtr->printInvertedBoard = *(int *) prompt("\nFlip the board during black's turn? (y/n)", BOOL);
-    gamePtr->turn = WHITE; /* white starts the game */
-    gamePtr->whiteCapturedPieces[0] = '\0';
-    gamePtr->blackCapturedPieces[0] = '\0';
-    gamePtr->whiteScore = 0;
-    gamePtr->blackScore = 0;
-    clearHighlights(gamePtr);
-
-    /* board */
-    char startingBoard[8][8] = {
-        'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r',
-        'p', 'p', 'p', 'p', 'p', 'p', 'p', 'p',
-        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
-        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
-        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
-        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
-        'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P',
-        'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R'
-    };
-    boardCopy(gamePtr->board, startingBoard);
-
-    return gamePtr;
-}
-
-/*
- * prints welcome messages, initializes a new GameState, runs playGame()
- * prints exit message.
- */
-int main() {
-    consoleSetup();
-    printf("Welcome to chess!\n");
-
-    GameState *gamePtr = initNewGame();
-
-    playGame(gamePtr);
-
-    free(gamePtr);
-
-    printf("Thanks for playing!\n");
-    return 0;
-}
+#include "chess.h"
+
+#define COMPUTER_HASH_MB 16 /* the engine's transposition table */
+
+/*
+ * asks which side the computer should play.
+ * returns WHITE, BLACK or NO_COLOR.
+ */
+int promptForComputerColor() {
+    while(TRUE) {
+        char *response = prompt("Computer plays (w)hite, (b)lack or (n)either?", 
+                                STRING);
+        char c = tolower(response[0]);
+        free(response);
+
+        switch(c) {
+            case 'w':
+                return WHITE;
+            case 'b':
+                return BLACK;
+            case 'n':
+                return NO_COLOR;
+        }
+    }
+}
+
+/*
+ * sets up a new game in *gamePtr, starting from the position in fen,
+ * based on default values and user input.
+ * returns FALSE if fen is not valid.
+ */
+int initNewGame(ConsoleGame *gamePtr, const char *fen) {
+    /* board, turn, castling rights, etc. */
+    if(!loadFen(&gamePtr->position, fen))
+        return FALSE;
+    initHistory(&gamePtr->history, &gamePtr->position);
+
+    /* init game's members */
+    gamePtr->printInvertedBoard = *(int *) prompt("\nFlip the board during black's turn? (y/n)", BOOL);
+    gamePtr->computerColor = promptForComputerColor();
+    gamePtr->computerSeconds = 0;
+    if(gamePtr->computerColor != NO_COLOR) {
+        int *secondsPtr = prompt("Seconds per computer move?", INT);
+        gamePtr->computerSeconds = *secondsPtr > 0 ? *secondsPtr : 1;
+        free(secondsPtr);
+    }
+    gamePtr->whiteCapturedPieces[0] = '\0';
+    gamePtr->blackCapturedPieces[0] = '\0';
+    gamePtr->whiteScore = 0;
+    gamePtr->blackScore = 0;
+    clearHighlights(gamePtr);
+
+    return TRUE;
+}
+
+/*
+ * plays move for the side to move (see makeMove),
+ * and sets player scores/captured accordingly.
+ * returns: the gameStatus() of the new position
+ */
+int executeMove(ConsoleGame *gamePtr, Move move) {
+    int color = gamePtr->position.turn;
+    UndoInfo undo;
+    makeMove(&gamePtr->position, move, &undo);
+    pushPosition(&gamePtr->history, gamePtr->position.hash);
+
+    /* update scores and captured */
+    char capturedPiece = undo.capturedPiece;
+    if(capturedPiece != ' ') {
+        if(color == WHITE) {
+            int numCaptured = strlen(gamePtr->whiteCapturedPieces);
+            gamePtr->whiteCapturedPieces[numCaptured] = capturedPiece;
+            gamePtr->whiteCapturedPieces[numCaptured+ 1 ] = '\0';
+
+            gamePtr->whiteScore += pieceValue(capturedPiece); 
+        }else {
+            int numCaptured = strlen(gamePtr->blackCapturedPieces);
+            gamePtr->blackCapturedPieces[numCaptured] = capturedPiece;
+            gamePtr->blackCapturedPieces[numCaptured + 1] = '\0';
+
+            gamePtr->blackScore += pieceValue(capturedPiece);
+        }
+    }
+
+    return gameStatus(&gamePtr->position, &gamePtr->history);
+}
+
+/*
+ * runs the basic game loop of gamePtr:
+ *     calls printGameInfo
+ *     prompts the user for a move (a move or request for possible mvoes),
+ *     or searches for one if it is the computer's turn
+ *     executes that move
+ *     (which swaps the turn and checks for game ending conditions)
+ * prints the losing condition
+ * (a game set up in a finished position ends at once)
+ *
+ * returns:
+ * int: losing condition of the game (STALEMATE, WHITE_CHECKMATE,
+ *                                    BLACK_CHECKMATE or a draw)
+ */
+void playGame(ConsoleGame *gamePtr) {
+    int losingCondition = gameStatus(&gamePtr->position, &gamePtr->history);
+
+    /* the engine keeps what it learns from one move to the next */
+    TranspositionTable tt;
+    TranspositionTable *ttPtr = NULL;
+    if(gamePtr->computerColor != NO_COLOR && initTranspositionTable(&tt, COMPUTER_HASH_MB))
+        ttPtr = &tt;
+
+    while(losingCondition == CONTINUE) {
+        printGameInfo(gamePtr);    
+
+        Move playerMove;
+        if(gamePtr->position.turn == gamePtr->computerColor) {
+            SearchLimits limits = {.maxSeconds = gamePtr->computerSeconds, .stopPtr = NULL};
+            playerMove = searchBestMove(&gamePtr->position, &gamePtr->history, 
+                                        ttPtr, &limits, NULL);
+            if(playerMove == NO_MOVE) {
+                /* no legal moves: the game is over, not worth retrying */
+                losingCondition = gameStatus(&gamePtr->position, &gamePtr->history);
+                break;
+            }
+        } else {
+            char playerMoveStr[] = "     ";
+            promptForMove(gamePtr, playerMoveStr);
+            playerMove = parseMove(&gamePtr->position, playerMoveStr);
+        }
+
+        if(!moveIsLegal(&gamePtr->position, playerMove)) {
+            continue; /* skip over the (execute and turn switch) 
+                         and prompt again */    
+        }
+
+        losingCondition = executeMove(gamePtr, playerMove);
+    }
+    printGameInfo(gamePtr);    
+    switch(losingCondition) {
+        case STALEMATE:
+            printf("Stalemate!\n");
+            break;
+        case WHITE_CHECKMATE:
+            printf("White checkmate!\n");
+            break;
+        case BLACK_CHECKMATE:
+            printf("Black checkmate!\n");
+            break;
+        case FIFTY_MOVE_DRAW:
+        case REPETITION_DRAW:
+        case MATERIAL_DRAW:
+            printf("Draw by %s!\n", statusName(losingCondition));
+            break;
+    }
+
+    if(ttPtr != NULL)
+        freeTranspositionTable(ttPtr);
+}
+
+/*
+ * prints welcome messages, initializes a new game
+ * (from the fen given as the first argument, if any), runs playGame()
+ * prints exit message.
+ */
+int main(int argc, char **argv) {
+    consoleSetup();
+    initEvalTables();
+    printf("Welcome to chess!\n");
+
+    ConsoleGame game;
+    if(!initNewGame(&game, (argc > 1) ? argv[1] : STARTING_FEN)) {
+        printf("Invalid fen: %s\n", argv[1]);
+        return 1;
+    }
+
+    playGame(&game);
+
+    printf("Thanks for playing!\n");
+    return 0;
+}
@@ -0,0 +1,542 @@
+/*
+ * core.h:
+ * the rules, move generation, search and perft, with no console
+ * or other platform dependencies (built into libchess.a).
+ * front ends include this (see chess.h for the console one).
+ */
+#ifndef CORE_H
+#define CORE_H
+
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h> /* threads and the clock only (see thread.c) */
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define WHITE 1
+#define BLACK 0
+#define NO_COLOR -1
+
+/* game status (see gameStatus) */
+#define STALEMATE 0
+#define WHITE_CHECKMATE 1
+#define BLACK_CHECKMATE 2
+#define CONTINUE 3
+#define FIFTY_MOVE_DRAW 4
+#define REPETITION_DRAW 5
+#define MATERIAL_DRAW 6
+
+#define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define MAX_FEN_LENGTH 128 /* including the '\0' */
+
+#define KING_SIDE_CASTLE "KCSL"
+#define QUEEN_SIDE_CASTLE "QCSL"
+
+/* booleans */
+#define TRUE 1
+#define FALSE 0
+
+/* piece types (index into GameState.pieceBoards) */
+#define PAWN 0
+#define KNIGHT 1
+#define BISHOP 2
+#define ROOK 3
+#define QUEEN 4
+#define KING 5
+#define NO_PIECE 6
+
+/*
+ * squares are numbered row * 8 + col (a8 = 0, h1 = 63),
+ * so bit n of a Bitboard is board[n / 8][n % 8].
+ */
+#define SQUARE(row, col) ((row) * 8 + (col))
+#define SQUARE_ROW(square) ((square) >> 3)
+#define SQUARE_COL(square) ((square) & 7)
+#define SQUARE_BIT(square) (1ULL << (square))
+#define NO_SQUARE 64
+
+/* castling rights (bits of GameState.castlingRights) */
+#define WHITE_KING_SIDE 1
+#define WHITE_QUEEN_SIDE 2
+#define BLACK_KING_SIDE 4
+#define BLACK_QUEEN_SIDE 8
+#define ALL_CASTLING_RIGHTS 15
+
+typedef unsigned long long Bitboard;
+
+/*
+ * magic bitboards: the squares a slider attacks depend only on the
+ * occupied squares in its mask (its rays, less the board edges).
+ * multiplying those by the square's magic number gathers them into
+ * the top bits, which index its slice of the attack table.
+ */
+typedef struct _magic {
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard *attacks; /* 1 << (64 - shift) entries */
+    int shift;
+} Magic;
+
+/*
+ * a move packed into 16 bits:
+ *     bits 0-5: source square, bits 6-11: destination square,
+ *     bits 12-15: flags (one of the *_FLAG values below)
+ * castles are encoded as the king's two-square move,
+ * en passant captures as the capturing pawn's move.
+ */
+typedef unsigned short Move;
+
+#define MOVE(source, dest, flags) ((Move) ((source) | ((dest) << 6) | ((flags) << 12)))
+#define MOVE_SOURCE(move) ((move) & 63)
+#define MOVE_DEST(move) (((move) >> 6) & 63)
+#define MOVE_FLAGS(move) ((move) >> 12)
+
+#define NO_MOVE 0 /* a8a8, never a real move */
+
+/* move flags */
+#define NORMAL_FLAG 0
+#define CASTLE_FLAG 1
+#define EN_PASSANT_FLAG 2 /* the captured pawn is beside source, not on dest */
+#define PROMOTION_FLAG 4 /* | (promoted piece type - KNIGHT) */
+
+#define PROMOTION_MOVE(source, dest, type) MOVE(source, dest, PROMOTION_FLAG | ((type) - KNIGHT))
+#define MOVE_IS_PROMOTION(move) (MOVE_FLAGS(move) & PROMOTION_FLAG)
+#define MOVE_PROMOTION_TYPE(move) ((MOVE_FLAGS(move) & 3) + KNIGHT)
+
+/* kinds of move, to generate them in stages (see getLegalMovesOfKind) */
+#define ALL_MOVES 0
+#define CAPTURE_MOVES 1 /* captures, en passant and promotions */
+#define QUIET_MOVES 2 /* every other move, castles included */
+
+/* enough room for the moves of any legal position */
+#define MAX_MOVES 256
+
+/*
+ * a fixed-size list of moves, meant to live on the stack
+ */
+typedef struct _moveList {
+    Move moves[MAX_MOVES];
+    int count;
+} MoveList;
+
+
+/* positions are aligned to cache lines, so none straddles more lines than it must */
+#define CACHE_LINE_SIZE 64
+
+/*
+ * a position: what move generation, search and the rules need,
+ * and nothing else (front ends keep their own state beside it).
+ * it is compact (four cache lines) so it can be copied per thread or
+ * per ply and packed densely in arrays; the bitboards and hash,
+ * the most used fields, share the first two lines.
+ */
+typedef struct _gameState {
+    /* bitboards, kept in sync with board by setSquare() */
+    Bitboard pieceBoards[2][6]; /* [color][piece type] */
+    Bitboard colorBoards[2]; /* [color]: every square that color occupies */
+    Bitboard occupied; /* every non-empty square */
+    unsigned long long hash; /* zobrist key, kept up to date by every move */
+
+    char board[8][8];
+
+    int turn; /* WHITE or BLACK */
+    int castlingRights; /* castles not yet ruled out by a king or rook move */
+    int enPassantSquare; /* square passed by a capturable double jump, or NO_SQUARE */
+    int halfmoveClock; /* plies since the last capture or pawn move */
+    int fullmoveNumber; /* starts at 1, incremented after each black move */
+
+    /* evaluation, kept up to date by setSquare() (see eval.c) */
+    int middlegameScore; /* material + piece-square, white minus black */
+    int endgameScore;
+    int phase; /* GAME_PHASE_MAX with all minor and major pieces, down to 0 */
+} __attribute__((aligned(CACHE_LINE_SIZE))) GameState;
+
+/*
+ * the checks and pins against a king, found once
+ * so legal moves can be generated directly
+ */
+typedef struct _checkInfo {
+    int kingSquare;
+    Bitboard checkers; /* enemy pieces giving check */
+    Bitboard pinned; /* friendly pieces pinned to the king */
+    Bitboard evasionTargets; /* squares that resolve the check (all, if none) */
+} CheckInfo;
+
+/*
+ * what makeMove changed that the move itself does not tell,
+ * so unmakeMove can restore it
+ */
+typedef struct _undoInfo {
+    unsigned long long hash;
+    char capturedPiece; /* ' ' if none */
+    int castlingRights;
+    int enPassantSquare;
+    int halfmoveClock;
+} UndoInfo;
+
+/*
+ * positions kept by a PositionHistory: a power of two, over the 100 plies
+ * after which the fifty-move rule ends the game, so no repetition is missed
+ */
+#define HISTORY_SIZE 128
+
+/*
+ * the hashes of a game's latest positions, to find repetitions
+ * (initHistory, pushPosition after each move, repetitionCount)
+ */
+typedef struct _positionHistory {
+    unsigned long long hashes[HISTORY_SIZE]; /* position n at n % HISTORY_SIZE */
+    int count; /* positions pushed */
+} PositionHistory;
+
+/*
+ * a transposition table: a fixed-size, power-of-two array of buckets
+ * indexed by position hash
+ */
+#define TT_BUCKET_SIZE 2
+
+typedef struct _ttEntry {
+    unsigned long long check; /* hash ^ data */
+    unsigned long long data;
+} TTEntry;
+
+typedef struct _ttBucket {
+    TTEntry entries[TT_BUCKET_SIZE];
+} TTBucket;
+
+/* what a stored search score is (see storeSearchEntry) */
+#define EXACT_SCORE 1
+#define LOWER_BOUND 2 /* the score is at least this (a move cut off) */
+#define UPPER_BOUND 3 /* the score is at most this (no move raised alpha) */
+
+typedef struct _transpositionTable {
+    TTBucket *buckets;
+    unsigned long long mask; /* number of buckets - 1 */
+    int generation; /* of the current search (see newTableGeneration) */
+} TranspositionTable;
+
+/* threads and locks (thread.c) */
+#ifdef _WIN32
+typedef HANDLE Thread;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+#else
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+#endif
+
+/*
+ * a growable block of text (see appendText)
+ */
+typedef struct _textBuffer {
+    char *text; /* not '\0' terminated */
+    long long length;
+    long long capacity;
+} TextBuffer;
+
+/*
+ * a read-only view of a whole file (see mapFile)
+ */
+typedef struct _mappedFile {
+    const char *data; /* NULL for an empty file */
+    long long length;
+} MappedFile;
+
+/*
+ * how runPipeline splits its input into records (E.G. lines or games)
+ * and analyzes them
+ */
+typedef struct _pipelineHandlers {
+    /* the end of the last whole record in data (0 if there is none) */
+    long long (*lastRecordEnd)(const char *data, long long length);
+
+    /* 
+     * called on worker threads with whole records, which start offset bytes 
+     * into the input, appending the results to outputPtr
+     */
+    void (*analyze)(void *context, const char *input, long long length, 
+                    long long offset, TextBuffer *outputPtr);
+    /* called in input order with each chunk's results (NULL: write to stdout) */
+    void (*write)(void *context, const char *output, long long length);
+
+    void *context; /* passed to analyze and write */
+} PipelineHandlers;
+
+#define MAX_PACKED_PIECES 32 /* pieces a PackedPosition has room for */
+
+/*
+ * a position packed into 32 bytes (see archive.c)
+ */
+typedef struct _packedPosition {
+    Bitboard occupied;
+    unsigned char pieces[MAX_PACKED_PIECES / 2]; /* a nibble per occupied square, in square order */
+    unsigned char flags; /* castling rights, and whether black is to move */
+    unsigned char enPassantSquare;
+    unsigned char halfmoveClock;
+    unsigned char reserved;
+    unsigned short fullmoveNumber;
+    unsigned char padding[2];
+} PackedPosition;
+
+/* game results (GameRecord.result) */
+#define GAME_RESULT_UNKNOWN 0
+#define GAME_RESULT_WHITE_WINS 1
+#define GAME_RESULT_BLACK_WINS 2
+#define GAME_RESULT_DRAW 3
+
+#define MAX_ARCHIVE_MOVES 65535
+
+/*
+ * a game in an archive: where it started, and every move since
+ */
+typedef struct _gameRecord {
+    PackedPosition start;
+    unsigned short numMoves;
+    unsigned char result; /* a GAME_RESULT value */
+    unsigned char reserved;
+    Move moves[]; /* numMoves of them */
+} GameRecord;
+
+/*
+ * an archive being written (createArchive, writeGameRecords, finishArchive)
+ */
+typedef struct _archiveWriter {
+    FILE *file;
+    long long offset; /* bytes written so far */
+    unsigned long long *index; /* the offset of every game */
+    long long numGames;
+    long long indexCapacity;
+} ArchiveWriter;
+
+/*
+ * an archive mapped in for reading (openArchive, archiveGame, closeArchive)
+ */
+typedef struct _archive {
+    MappedFile file;
+    const unsigned long long *index;
+    long long numGames;
+} Archive;
+
+#define POOL_SLAB_GAMES 1024 /* games allocated at once by a GamePool */
+
+/*
+ * a game hosted in a GamePool
+ */
+typedef struct _pooledGame {
+    GameState position;
+    PositionHistory history;
+    int numMoves; /* played since the game started */
+    int inUse;
+    int nextFree; /* while not in use: the next free slot (-1: none) */
+    unsigned int generation; /* times the slot has been reused */
+} __attribute__((aligned(CACHE_LINE_SIZE))) PooledGame;
+
+/*
+ * many games, allocated in slabs and found by id
+ * (newPoolGame, poolGame, endPoolGame; see gamepool.c)
+ */
+typedef struct _gamePool {
+    PooledGame **slabs; /* POOL_SLAB_GAMES games each */
+    int numSlabs;
+    int firstFree; /* the first free slot (-1: every slot is in use) */
+    int numGames; /* in use */
+} GamePool;
+
+/* search scores (centipawns) */
+#define INFINITE_SCORE 32000
+#define MATE_SCORE 31000 /* minus the plies to mate */
+#define MAX_SEARCH_DEPTH 64
+
+#define GAME_PHASE_MAX 24
+
+/*
+ * the limits of a search (0 for none)
+ */
+typedef struct _searchResult SearchResult;
+typedef struct _searchLimits {
+    int maxDepth;
+    double maxSeconds;
+    long long maxNodes;
+    void (*onIteration)(SearchResult *resultPtr); /* NULL, or called per depth */
+    volatile int *stopPtr; /* NULL, or a flag another thread sets to stop the search */
+} SearchLimits;
+
+/*
+ * what a search found, as of its deepest completed iteration
+ */
+struct _searchResult {
+    Move bestMove;
+    int score; /* for the side to move */
+    int depth;
+    long long nodes; /* total, over every iteration */
+    long long iterationNodes; /* of the last iteration only */
+    double seconds;
+};
+
+/* game.c */
+int pieceIsWhite(char piece);
+int pieceValue(char pieceName);
+Move parseMove(GameState *gamePtr, char *moveStr);
+Move parseUciMove(GameState *gamePtr, char *moveStr);
+void moveToString(Move move, char *moveStr);
+void makeMove(GameState *gamePtr, Move move, UndoInfo *undoPtr);
+void unmakeMove(GameState *gamePtr, Move move, UndoInfo *undoPtr);
+int moveIsLegal(GameState *gamePtr, Move move);
+void initHistory(PositionHistory *historyPtr, GameState *gamePtr);
+void pushPosition(PositionHistory *historyPtr, unsigned long long hash);
+void popPosition(PositionHistory *historyPtr);
+int repetitionCount(PositionHistory *historyPtr, GameState *gamePtr);
+int hasInsufficientMaterial(GameState *gamePtr);
+int positionIsLegal(GameState *gamePtr);
+int drawStatus(GameState *gamePtr, PositionHistory *historyPtr);
+int gameStatus(GameState *gamePtr, PositionHistory *historyPtr);
+const char *statusName(int status);
+int letterToCol(char letter);
+int colToLetter(int col);
+int letterToRow(char letter);
+int rowToLetter(int row);
+
+/* bitboard.c */
+int pieceType(char piece);
+char pieceChar(int type, int color);
+void setSquare(GameState *gamePtr, int row, int col, char piece);
+void syncBitboards(GameState *gamePtr);
+int popLowestSquare(Bitboard *bitboardPtr);
+Bitboard knightAttacks(int square);
+Bitboard kingAttacks(int square);
+Bitboard pawnAttacks(int square, int color);
+Bitboard rookAttacks(int square, Bitboard occupied);
+Bitboard bishopAttacks(int square, Bitboard occupied);
+Bitboard squaresBetween(int a, int b);
+Bitboard lineThrough(int a, int b);
+
+/* zobrist.c */
+unsigned long long computeHash(GameState *gamePtr);
+
+/* tables.c (generated by gentables.c) */
+extern const Bitboard knightAttackTable[64];
+extern const Bitboard kingAttackTable[64];
+extern const Bitboard pawnAttackTable[2][64]; /* [color][square] */
+extern const Bitboard betweenTable[64][64];
+extern const Bitboard lineTable[64][64];
+extern const Bitboard rookAttackTable[];
+extern const Bitboard bishopAttackTable[];
+extern const Magic rookMagics[64];
+extern const Magic bishopMagics[64];
+extern const unsigned long long pieceKeys[2][6][64]; /* [color][piece type][square] */
+extern const unsigned long long castlingKeys[16]; /* [castling rights] */
+extern const unsigned long long enPassantKeys[8]; /* [col] */
+extern const unsigned long long blackToMoveKey;
+
+/* tt.c */
+int initTranspositionTable(TranspositionTable *ttPtr, int megabytes);
+void freeTranspositionTable(TranspositionTable *ttPtr);
+void clearTranspositionTable(TranspositionTable *ttPtr);
+void newTableGeneration(TranspositionTable *ttPtr);
+int probeNodeCount(TranspositionTable *ttPtr, unsigned long long hash, int depth, 
+                   long long *nodesPtr);
+void storeNodeCount(TranspositionTable *ttPtr, unsigned long long hash, int depth, 
+                    long long nodes);
+int probeSearchEntry(TranspositionTable *ttPtr, unsigned long long hash, int *depthPtr,
+                     int *scorePtr, int *boundPtr, Move *movePtr);
+void storeSearchEntry(TranspositionTable *ttPtr, unsigned long long hash, int depth,
+                      int score, int bound, Move move);
+
+/* thread.c */
+int startThread(Thread *threadPtr, void (*function)(void *), void *arg);
+void joinThread(Thread thread);
+void initMutex(Mutex *mutexPtr);
+void lockMutex(Mutex *mutexPtr);
+void unlockMutex(Mutex *mutexPtr);
+void destroyMutex(Mutex *mutexPtr);
+void initCondition(Condition *conditionPtr);
+void waitCondition(Condition *conditionPtr, Mutex *mutexPtr);
+void broadcastCondition(Condition *conditionPtr);
+void destroyCondition(Condition *conditionPtr);
+int processorCount();
+double wallClockSeconds();
+
+/* eval.c */
+extern int middlegameValues[2][6][64];
+extern int endgameValues[2][6][64];
+extern int phaseValues[6];
+void initEvalTables();
+int evaluate(GameState *gamePtr);
+
+/* search.c */
+Move searchBestMove(GameState *gamePtr, PositionHistory *historyPtr,
+                    TranspositionTable *ttPtr, SearchLimits *limitsPtr, 
+                    SearchResult *resultPtr);
+
+/* fen.c */
+const char *parseFen(GameState *gamePtr, const char *fen);
+int loadFen(GameState *gamePtr, const char *fen);
+int writeFen(GameState *gamePtr, char *fen);
+
+/* perft.c */
+long long perft(GameState *gamePtr, int depth);
+long long perftParallel(GameState *gamePtr, int depth, TranspositionTable *ttPtr, 
+                        int numThreads, long long *rootNodes);
+long long perftDivide(GameState *gamePtr, int depth, TranspositionTable *ttPtr, 
+                      int numThreads);
+long long perftHashed(GameState *gamePtr, int depth, TranspositionTable *ttPtr);
+long long perftCopyMake(GameState *gamePtr, int depth);
+
+/* san.c */
+Move parseSan(GameState *gamePtr, const char *san, int length);
+
+/* archive.c */
+int packPosition(GameState *gamePtr, PackedPosition *packedPtr);
+int unpackPosition(GameState *gamePtr, const PackedPosition *packedPtr);
+long long gameRecordSize(int numMoves);
+void appendGameRecord(TextBuffer *bufferPtr, const PackedPosition *startPtr,
+                      const Move *moves, int numMoves, int result);
+int createArchive(ArchiveWriter *writerPtr, const char *path);
+void writeGameRecords(ArchiveWriter *writerPtr, const char *records, 
+                      long long length);
+int finishArchive(ArchiveWriter *writerPtr);
+int archiveIndexIsValid(const MappedFile *filePtr, const unsigned long long *index,
+                        unsigned long long numGames, unsigned long long indexOffset);
+int openArchive(Archive *archivePtr, const char *path);
+const GameRecord *archiveGame(Archive *archivePtr, long long gameIndex);
+void closeArchive(Archive *archivePtr);
+
+/* gamepool.c */
+void initGamePool(GamePool *poolPtr);
+long long newPoolGame(GamePool *poolPtr, const char *fen);
+PooledGame *poolGame(GamePool *poolPtr, long long id);
+int endPoolGame(GamePool *poolPtr, long long id);
+void freeGamePool(GamePool *poolPtr);
+
+/* pipeline.c */
+int mapFile(MappedFile *filePtr, const char *path);
+void unmapFile(MappedFile *filePtr);
+void appendText(TextBuffer *bufferPtr, const char *text, int length);
+long long lastLineEnd(const char *data, long long length);
+int runPipeline(const char *path, PipelineHandlers *handlersPtr, int numThreads);
+
+/* moves.c */
+int getAllMoves(GameState *gamePtr, MoveList *moveList, int color);
+int getPieceLegalMoves(GameState *gamePtr, MoveList *moveList, int row, int col);
+int getAllLegalMoves(GameState *gamePtr, MoveList *moveList, int color);
+int getLegalMovesOfKind(GameState *gamePtr, MoveList *moveList, int color, 
+                        int kind, CheckInfo *infoPtr);
+int getLegalCaptures(GameState *gamePtr, MoveList *moveList, int color, 
+                     CheckInfo *infoPtr);
+int squareIsAttacked(GameState *gamePtr, int square, int byColor);
+Bitboard attackersOf(GameState *gamePtr, int square, int byColor);
+void findCheckInfo(GameState *gamePtr, int color, CheckInfo *infoPtr);
+int isKingInCheck(GameState *gamePtr, int color);
+int canCastle(GameState *gamePtr, int color, int isKingSide);
+int putsKingInCheck(GameState *gamePtr, Move move, int color);
+
+#endif
@@ -0,0 +1,150 @@
+#include "core.h"
+
+/*
+ * piece-square tables, in centipawns, for white
+ * (row 0 is rank 8, as on the board; black uses them mirrored).
+ */
+int pawnMiddlegame[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+int pawnEndgame[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+int knightTable[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+int bishopTable[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+int rookTable[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+int queenTable[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+int kingMiddlegame[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+int kingEndgame[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+int *middlegameTables[6] = {pawnMiddlegame, knightTable, bishopTable, 
+                            rookTable, queenTable, kingMiddlegame};
+int *endgameTables[6] = {pawnEndgame, knightTable, bishopTable, 
+                         rookTable, queenTable, kingEndgame};
+
+/* 
+ * material + piece-square score of each piece on each square,
+ * positive for white and negative for black (filled in by initEvalTables)
+ */
+int middlegameValues[2][6][64]; /* [color][piece type][square] */
+int endgameValues[2][6][64];
+
+/* how much each piece type counts towards the middlegame (GAME_PHASE_MAX) */
+int phaseValues[6] = {0, 1, 1, 2, 4, 0};
+
+/*
+ * fills in middlegameValues and endgameValues.
+ * must be called once, before any GameState is set up.
+ */
+void initEvalTables() {
+    for(int type = PAWN; type <= KING; type++) {
+        int material = 100 * pieceValue(pieceChar(type, WHITE));
+
+        for(int square = 0; square < 64; square++) {
+            /* black's square, seen from white's side of the board */
+            int mirrored = square ^ 56;
+
+            middlegameValues[WHITE][type][square] = 
+                material + middlegameTables[type][square];
+            endgameValues[WHITE][type][square] = 
+                material + endgameTables[type][square];
+            middlegameValues[BLACK][type][square] = 
+                -(material + middlegameTables[type][mirrored]);
+            endgameValues[BLACK][type][square] = 
+                -(material + endgameTables[type][mirrored]);
+        }
+    }
+}
+
+/*
+ * evaluate:
+ * scores the position in centipawns, from the point of view of the
+ * side to move (positive is good for gamePtr->turn).
+ * material and piece-square scores are kept up to date by setSquare,
+ * so this only blends the middlegame and endgame scores by game phase.
+ */
+int evaluate(GameState *gamePtr) {
+    int phase = gamePtr->phase;
+    if(phase > GAME_PHASE_MAX)
+        phase = GAME_PHASE_MAX; /* promotions can push past the opening */
+
+    int score = (gamePtr->middlegameScore * phase + 
+                 gamePtr->endgameScore * (GAME_PHASE_MAX - phase)) / GAME_PHASE_MAX;
+
+    return (gamePtr->turn == WHITE) ? score : -score;
+}
@@ -0,0 +1,240 @@
+#include "core.h"
+
+/* spaces and tabs separate fields; anything else ends the fen */
+#define IS_FIELD_SPACE(c) ((c) == ' ' || (c) == '\t')
+#define IS_FEN_END(c) ((c) == '\0' || isspace((unsigned char) (c)))
+
+/*
+ * skips the spaces before the next field
+ */
+const char *skipFieldSpace(const char *fen) {
+    while(IS_FIELD_SPACE(*fen))
+        fen++;
+    return fen;
+}
+
+/*
+ * reads a move counter at *fenPtr into *valuePtr, advancing *fenPtr.
+ * leaves both alone if there is no number there.
+ */
+void parseCounter(const char **fenPtr, int *valuePtr) {
+    const char *fen = skipFieldSpace(*fenPtr);
+    if(!isdigit((unsigned char) *fen))
+        return;
+
+    int value = 0;
+    for(; isdigit((unsigned char) *fen); fen++)
+        value = value * 10 + (*fen - '0');
+
+    *valuePtr = value;
+    *fenPtr = fen;
+}
+
+/*
+ * parse fen:
+ * sets up gamePtr from a position in Forsyth-Edwards Notation
+ * (E.G. STARTING_FEN), reading straight out of fen without copying it.
+ * the fen ends at a newline or '\0', so fen can point into a buffer
+ * holding many of them. the move counters may be left out
+ * (they default to 0 and 1).
+ *
+ * returns:
+ * a pointer just past the fen, or NULL if it could not be parsed
+ * or is not a legal position (see positionIsLegal; gamePtr is then undefined)
+ */
+const char *parseFen(GameState *gamePtr, const char *fen) {
+    memset(gamePtr, 0, sizeof(GameState));
+    memset(gamePtr->board, ' ', sizeof(gamePtr->board));
+
+    /* piece placement, from row 0 (rank 8) down */
+    int row = 0;
+    int col = 0;
+    for(; !IS_FEN_END(*fen); fen++) {
+        if(*fen == '/') {
+            if(col != 8)
+                return NULL;
+            row++;
+            col = 0;
+        } else if(*fen >= '1' && *fen <= '8') {
+            col += *fen - '0';
+        } else if(pieceType(*fen) != NO_PIECE && row < 8 && col < 8) {
+            setSquare(gamePtr, row, col++, *fen);
+        } else {
+            return NULL;
+        }
+
+        if(col > 8)
+            return NULL;
+    }
+    if(row != 7 || col != 8)
+        return NULL;
+
+    /* side to move */
+    fen = skipFieldSpace(fen);
+    if(*fen == 'w') {
+        gamePtr->turn = WHITE;
+    } else if(*fen == 'b') {
+        gamePtr->turn = BLACK;
+    } else {
+        return NULL;
+    }
+    fen++;
+
+    /* kings, piece counts and checks the move generator relies on */
+    if(!positionIsLegal(gamePtr))
+        return NULL;
+
+    /* castling rights */
+    fen = skipFieldSpace(fen);
+    for(; !IS_FEN_END(*fen); fen++) {
+        switch(*fen) {
+            case 'K':
+                gamePtr->castlingRights |= WHITE_KING_SIDE;
+                break;
+            case 'Q':
+                gamePtr->castlingRights |= WHITE_QUEEN_SIDE;
+                break;
+            case 'k':
+                gamePtr->castlingRights |= BLACK_KING_SIDE;
+                break;
+            case 'q':
+                gamePtr->castlingRights |= BLACK_QUEEN_SIDE;
+                break;
+            case '-':
+                break;
+            default:
+                return NULL;
+        }
+    }
+
+    /* 
+     * en passant square: kept only if a pawn can capture there,
+     * the same as after a double jump in the game
+     */
+    gamePtr->enPassantSquare = NO_SQUARE;
+    fen = skipFieldSpace(fen);
+    if(*fen >= 'a' && *fen <= 'h' && (fen[1] == '3' || fen[1] == '6')) {
+        int square = SQUARE(letterToRow(fen[1]), letterToCol(fen[0]));
+        int capturer = gamePtr->turn;
+        if(pawnAttacks(square, !capturer) & gamePtr->pieceBoards[capturer][PAWN])
+            gamePtr->enPassantSquare = square;
+        fen += 2;
+    } else if(*fen == '-') {
+        fen++;
+    } else if(!IS_FEN_END(*fen)) {
+        return NULL;
+    }
+
+    /* move counters */
+    gamePtr->halfmoveClock = 0;
+    gamePtr->fullmoveNumber = 1;
+    parseCounter(&fen, &gamePtr->halfmoveClock);
+    parseCounter(&fen, &gamePtr->fullmoveNumber);
+    fen = skipFieldSpace(fen);
+    if(!IS_FEN_END(*fen))
+        return NULL;
+
+    /* setSquare has hashed the pieces already */
+    gamePtr->hash ^= castlingKeys[gamePtr->castlingRights];
+    if(gamePtr->enPassantSquare != NO_SQUARE)
+        gamePtr->hash ^= enPassantKeys[SQUARE_COL(gamePtr->enPassantSquare)];
+    if(gamePtr->turn == BLACK)
+        gamePtr->hash ^= blackToMoveKey;
+
+    return fen;
+}
+
+/*
+ * load fen:
+ * sets up gamePtr from a single fen string (see parseFen)
+ *
+ * returns:
+ * TRUE if fen was parsed, FALSE otherwise (gamePtr is then undefined)
+ */
+int loadFen(GameState *gamePtr, const char *fen) {
+    return parseFen(gamePtr, fen) != NULL;
+}
+
+/*
+ * writes an unsigned number into fen, returning the end of it
+ */
+char *writeNumber(char *fen, int value) {
+    char digits[12];
+    int numDigits = 0;
+    do {
+        digits[numDigits++] = '0' + value % 10;
+        value /= 10;
+    } while(value > 0);
+
+    while(numDigits > 0)
+        *fen++ = digits[--numDigits];
+    return fen;
+}
+
+/*
+ * write fen:
+ * writes the position in gamePtr into fen in Forsyth-Edwards Notation.
+ * fen needs room for MAX_FEN_LENGTH chars.
+ *
+ * returns:
+ * the length of the fen
+ */
+int writeFen(GameState *gamePtr, char *fen) {
+    char *start = fen;
+
+    /* piece placement */
+    for(int row = 0; row < 8; row++) {
+        int emptySquares = 0;
+        for(int col = 0; col < 8; col++) {
+            char piece = gamePtr->board[row][col];
+            if(piece == ' ') {
+                emptySquares++;
+                continue;
+            }
+            if(emptySquares > 0) {
+                *fen++ = '0' + emptySquares;
+                emptySquares = 0;
+            }
+            *fen++ = piece;
+        }
+        if(emptySquares > 0)
+            *fen++ = '0' + emptySquares;
+        if(row < 7)
+            *fen++ = '/';
+    }
+
+    /* side to move */
+    *fen++ = ' ';
+    *fen++ = (gamePtr->turn == WHITE) ? 'w' : 'b';
+
+    /* castling rights */
+    *fen++ = ' ';
+    if(gamePtr->castlingRights == 0)
+        *fen++ = '-';
+    if(gamePtr->castlingRights & WHITE_KING_SIDE)
+        *fen++ = 'K';
+    if(gamePtr->castlingRights & WHITE_QUEEN_SIDE)
+        *fen++ = 'Q';
+    if(gamePtr->castlingRights & BLACK_KING_SIDE)
+        *fen++ = 'k';
+    if(gamePtr->castlingRights & BLACK_QUEEN_SIDE)
+        *fen++ = 'q';
+
+    /* en passant square */
+    *fen++ = ' ';
+    if(gamePtr->enPassantSquare == NO_SQUARE) {
+        *fen++ = '-';
+    } else {
+        *fen++ = colToLetter(SQUARE_COL(gamePtr->enPassantSquare));
+        *fen++ = rowToLetter(SQUARE_ROW(gamePtr->enPassantSquare));
+    }
+
+    /* move counters */
+    *fen++ = ' ';
+    fen = writeNumber(fen, gamePtr->halfmoveClock);
+    *fen++ = ' ';
+    fen = writeNumber(fen, gamePtr->fullmoveNumber);
+    *fen = '\0';
+
+    return fen - start;
+}
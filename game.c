@@ -1,330 +1,485 @@
-#include "chess.h"
-
-
-/*
- * free string array:
- * frees all char * elements of an array,
- * then frees the array itself.
- */
-void freeStringArray(char **arr, int length) {
-    for(int i = 0; i < length; i++) {
-        free(arr[i]);
-    }
-    free(arr);
-}
-
-/*
- * letter to col:
- * converts a letter to the col number
- */
-int letterToCol(char letter) {
-    return letter - 'a';
-}
-
-/*
- * col to letter:
- * converts the col number to a letter
- */
-int colToLetter(int col) {
-    return col + 'a';
-}
-
-/*
- * letter to row:
- * converts a letter to the row number
- */
-int letterToRow(char letter) {
-    return 8 - letter + '0';
-}
-
-/*
- * row to letter:
- * converts the row number to a letter
- */
-int rowToLetter(int row) {
-    return -row + '0' + 8;
-}
-
-/*
- * pieceIsWhite:
- * is the piece white (uppercase) ?
- */
-int pieceIsWhite(char piece) {
-    return(tolower(piece) != piece);
-}
-
-/*
- * returns the "value score" of the chess piece
- */
-int pieceValue(char pieceName) {
-    switch(tolower(pieceName)) {
-        case 'p':
-            return 1;
-        case 'b': case 'n':
-            return 3;
-        case 'r':
-            return 5;
-        case 'q':
-            return 9;
-    }
-}
-
-/*
- * checks the board for checkmate and stalemate:
- * returns CONTINUE (neither), CHECKMATE, or STALEMATE
- */
-int checkLosingCondition(GameState *gamePtr) {
-    char **possibleOpponentMoves = malloc(150 * sizeof(char *));    
-    int numOpponentMoves = getAllLegalMoves(gamePtr, possibleOpponentMoves, 
-                                            !gamePtr->turn);
-
-    if(numOpponentMoves == 0) {
-        if(isKingInCheck(gamePtr, !gamePtr->turn)) {
-            return gamePtr->turn ? WHITE_CHECKMATE : BLACK_CHECKMATE;
-        } else {
-            return STALEMATE;
-        }
-    }
-
-    /* free possibleOpponentMoves */
-    freeStringArray(possibleOpponentMoves, numOpponentMoves);
-
-    return CONTINUE;
-}
-
-/*
- * moves the piece on the board,
- * and sets player scores/captured accordingly.
- * returns: CONTINUE, STALEMATE, or CHECKMATE
- */
-int executeMove(GameState *gamePtr, char *move) {
-    /* make castles */
-    if(strcmp(move, KING_SIDE_CASTLE) == 0) {
-        int row = gamePtr->turn == WHITE ? 7 : 0;
-
-        gamePtr->board[row][5] = gamePtr->board[row][7];
-        gamePtr->board[row][6] = gamePtr->board[row][4];
-        gamePtr->board[row][4] = ' ';
-        gamePtr->board[row][7] = ' ';
-
-        goto ret;
-    } else if(strcmp(move, QUEEN_SIDE_CASTLE) == 0) { 
-        int row = gamePtr->turn == WHITE ? 7 : 0;
-
-        gamePtr->board[row][3] = gamePtr->board[row][0];
-        gamePtr->board[row][2] = gamePtr->board[row][4];
-        gamePtr->board[row][4] = ' ';
-        gamePtr->board[row][0] = ' ';
-
-        goto ret;
-    }
-
-    /* regular two-coordinate move */
-    int sourceCol = letterToCol(move[0]);
-    int sourceRow = letterToRow(move[1]);    
-    int destCol = letterToCol(move[2]);
-    int destRow = letterToRow(move[3]);
-
-    /* update scores and captured */
-    char movingPiece = gamePtr->board[sourceRow][sourceCol];
-    char capturedPiece = gamePtr->board[destRow][destCol]; 
-    if(capturedPiece != ' ') {
-        if(gamePtr->turn == WHITE) {
-            int numCaptured = strlen(gamePtr->whiteCapturedPieces);
-            gamePtr->whiteCapturedPieces[numCaptured] = capturedPiece;
-            gamePtr->whiteCapturedPieces[numCaptured+ 1 ] = '\0';
-
-            gamePtr->whiteScore += pieceValue(capturedPiece); 
-        }else {
-            int numCaptured = strlen(gamePtr->blackCapturedPieces);
-            gamePtr->blackCapturedPieces[numCaptured] = capturedPiece;
-            gamePtr->blackCapturedPieces[numCaptured + 1] = '\0';
-
-            gamePtr->blackScore += pieceValue(capturedPiece);
-        }
-    }
-
-    /* check for pawn promotion */
-    int isEndRow = destRow == 7 || destRow == 0;
-    int isPawn = tolower(movingPiece) == 'p';
-    if(isEndRow && isPawn) {
-        movingPiece = promptOnPawnPromote();
-
-        if(gamePtr->turn == WHITE) /* set the piece to the correct color */
-            movingPiece -= 'a' - 'A';
-    }
-
-
-    /* make move */
-    gamePtr->board[destRow][destCol] = movingPiece; 
-    gamePtr->board[sourceRow][sourceCol] = ' ';
-
-    /* return losing condition */
-    ret:
-    return checkLosingCondition(gamePtr);
-}
-
-/*
- * the move is executed, only changing the board
- * (no scores/captures are updated)
- * returns the overwritten piece (to be passed into reverseMove)
- */
-char tempExecuteMove(GameState *gamePtr, char *move, int color) {
-    /* castles */
-    if(strcmp(move, KING_SIDE_CASTLE) == 0) {
-        int row = color == WHITE ? 7 : 0;
-
-        gamePtr->board[row][5] = gamePtr->board[row][7];
-        gamePtr->board[row][6] = gamePtr->board[row][4];
-        gamePtr->board[row][4] = ' ';
-        gamePtr->board[row][7] = ' ';
-        
-        return ' ';
-    } else if(strcmp(move, QUEEN_SIDE_CASTLE) == 0) { 
-        int row = color == WHITE ? 7 : 0;
-
-        gamePtr->board[row][3] = gamePtr->board[row][0];
-        gamePtr->board[row][2] = gamePtr->board[row][4];
-        gamePtr->board[row][4] = ' ';
-        gamePtr->board[row][0] = ' ';
-
-        return ' ';
-    }
-
-    /* regular two-coordinate move */
-    int sourceCol = letterToCol(move[0]);
-    int sourceRow = letterToRow(move[1]);    
-    int destCol = letterToCol(move[2]);
-    int destRow = letterToRow(move[3]);
-
-    char overwrittenPiece = gamePtr->board[destRow][destCol]; 
-
-    /* make move */
-    gamePtr->board[destRow][destCol] = gamePtr->board[sourceRow][sourceCol]; 
-
-    return overwrittenPiece;
-}
-
-/*
- * reverses a move that was temporarily executed.
- */
-void reverseMove(GameState *gamePtr, char *move, int color, char overwrittenPiece) {
-    /* castles */
-    if(strcmp(move, KING_SIDE_CASTLE) == 0) {
-        int row = color == WHITE ? 7 : 0;
-
-        gamePtr->board[row][4] = gamePtr->board[row][6];
-        gamePtr->board[row][7] = gamePtr->board[row][5];
-        gamePtr->board[row][5] = ' ';
-        gamePtr->board[row][6] = ' ';
-        
-        return;
-    } else if(strcmp(move, QUEEN_SIDE_CASTLE) == 0) { 
-        int row = color == WHITE ? 7 : 0;
-
-        gamePtr->board[row][4] = gamePtr->board[row][2];
-        gamePtr->board[row][0] = gamePtr->board[row][3];
-        gamePtr->board[row][3] = ' ';
-        gamePtr->board[row][2] = ' ';
-
-        return;
-    }
-
-    /* regular two-coordinate move */
-    int sourceCol = letterToCol(move[0]);
-    int sourceRow = letterToRow(move[1]);    
-    int destCol = letterToCol(move[2]);
-    int destRow = letterToRow(move[3]);
-
-    /* reverse move */
-    gamePtr->board[sourceRow][sourceCol] = gamePtr->board[destRow][destCol];
-    gamePtr->board[destRow][destCol] = overwrittenPiece; 
-
-}
-
-
-/*
- * checks if move is legal (based on the board)
- */
-int moveIsLegal(GameState *gamePtr, char *move) {
-    if(strcmp(move, KING_SIDE_CASTLE) == 0) {
-        return canCastle(gamePtr, gamePtr->turn, TRUE);
-    } else if(strcmp(move, QUEEN_SIDE_CASTLE) == 0) {
-        return canCastle(gamePtr, gamePtr->turn, FALSE); 
-    }
-
-    int sourceCol = letterToCol(move[0]);
-    int sourceRow = letterToRow(move[1]);    
-    int destCol = letterToCol(move[2]);
-    int destRow = letterToRow(move[3]);
-
-    /* make sure piece matches player color */
-    char pieceType = gamePtr->board[sourceRow][sourceCol];
-    if(pieceType == ' ' || (pieceIsWhite(pieceType) != gamePtr->turn )) {
-        return FALSE;
-    }
-
-    /* get pieceLegalMoves */
-    char **possiblePieceMoves = malloc(30 * sizeof(char *));
-    int numPieceMoves = getPieceLegalMoves(gamePtr, possiblePieceMoves, 
-                                           sourceRow, sourceCol); 
-
-    for(int i = 0; i < numPieceMoves; i++) {
-        if(possiblePieceMoves[i][2] == colToLetter(destCol) && 
-           possiblePieceMoves[i][3] == rowToLetter(destRow)) {
-            freeStringArray(possiblePieceMoves, numPieceMoves);
-            return TRUE;
-        }
-    }
-
-    freeStringArray(possiblePieceMoves, numPieceMoves);
-    return FALSE;
-}
-
-/*
- * runs the basic game loop of gamePtr:
- *     calls printGameInfo
- *     prompts the user for a move (a move or request for possible mvoes)
- *     executes that move
- *     checks for game ending conditions
- *     swaps the turn
- * prints the losing condition
- *
- * returns:
- * int: losing condition of the game (STALEMATE or 
- *                                    WHITE_CHECKMATE or BLACK_CHECKMATE)
- */
-void playGame(GameState *gamePtr) {
-    int losingCondition;
-    while(TRUE) {
-        printGameInfo(gamePtr);    
-
-        char playerMove[] = "    ";
-        promptForMove(gamePtr, playerMove);
-
-        if(!moveIsLegal(gamePtr, playerMove)) {
-            continue; /* skip over the (execute and turn switch) 
-                         and prompt again */    
-        }
-
-        if((losingCondition = executeMove(gamePtr, playerMove)) != CONTINUE) {
-            break;
-        }
-        
-        gamePtr->turn = !gamePtr->turn; /* flip turn */
-
-    }
-    printGameInfo(gamePtr);    
-    switch(losingCondition) {
-        case STALEMATE:
-            printf("Stalemate!\n");
-            break;
-        case WHITE_CHECKMATE:
-            printf("White checkmate!\n");
-            break;
-        case BLACK_CHECKMATE:
-            printf("Black checkmate!\n");
-            break;
-    }
-
-}
+#include "core.h"
+
+
+/*
+ * letter to col:
+ * converts a letter to the col number
+ */
+int letterToCol(char letter) {
+    return letter - 'a';
+}
+
+/*
+ * col to letter:
+ * converts the col number to a letter
+ */
+int colToLetter(int col) {
+    return col + 'a';
+}
+
+/*
+ * letter to row:
+ * converts a letter to the row number
+ */
+int letterToRow(char letter) {
+    return 8 - letter + '0';
+}
+
+/*
+ * row to letter:
+ * converts the row number to a letter
+ */
+int rowToLetter(int row) {
+    return -row + '0' + 8;
+}
+
+/*
+ * pieceIsWhite:
+ * is the piece white (uppercase) ?
+ */
+int pieceIsWhite(char piece) {
+    return(tolower(piece) != piece);
+}
+
+/*
+ * returns the "value score" of the chess piece
+ */
+int pieceValue(char pieceName) {
+    switch(tolower(pieceName)) {
+        case 'p':
+            return 1;
+        case 'b': case 'n':
+            return 3;
+        case 'r':
+            return 5;
+        case 'q':
+            return 9;
+    }
+    return 0; /* kings are never captured */
+}
+
+/*
+ * parse move:
+ * converts a coordinate pair (E.G. a2b4, with an optional promotion
+ * piece, E.G. a7a8q) or KING_SIDE_CASTLE/QUEEN_SIDE_CASTLE
+ * into a Move for the player whose turn it is.
+ */
+Move parseMove(GameState *gamePtr, char *moveStr) {
+    int castleRow = (gamePtr->turn == WHITE) ? 7 : 0;
+    if(strcmp(moveStr, KING_SIDE_CASTLE) == 0) {
+        return MOVE(SQUARE(castleRow, 4), SQUARE(castleRow, 6), CASTLE_FLAG);
+    } else if(strcmp(moveStr, QUEEN_SIDE_CASTLE) == 0) {
+        return MOVE(SQUARE(castleRow, 4), SQUARE(castleRow, 2), CASTLE_FLAG);
+    }
+
+    int sourceCol = letterToCol(moveStr[0]);
+    int sourceRow = letterToRow(moveStr[1]);    
+    int destCol = letterToCol(moveStr[2]);
+    int destRow = letterToRow(moveStr[3]);
+    int source = SQUARE(sourceRow, sourceCol);
+    int dest = SQUARE(destRow, destCol);
+
+    int movingType = pieceType(gamePtr->board[sourceRow][sourceCol]);
+    if(movingType == KING && abs(destCol - sourceCol) == 2) {
+        return MOVE(source, dest, CASTLE_FLAG);
+    }
+
+    /* a diagonal pawn move onto an empty square */
+    if(movingType == PAWN && destCol != sourceCol && 
+       gamePtr->board[destRow][destCol] == ' ') {
+        return MOVE(source, dest, EN_PASSANT_FLAG);
+    }
+
+    if(movingType == PAWN && (destRow == 0 || destRow == 7)) {
+        int promotionType = pieceType(moveStr[4]);
+        if(promotionType < KNIGHT || promotionType > QUEEN) {
+            promotionType = QUEEN;
+        }
+        return PROMOTION_MOVE(source, dest, promotionType);
+    }
+
+    return MOVE(source, dest, NORMAL_FLAG);
+}
+
+/*
+ * parse uci move:
+ * parses a move in UCI's long algebraic notation (E.G. e2e4, e7e8q, e1g1)
+ *
+ * returns:
+ * the move, or NO_MOVE if it is not a legal move in gamePtr
+ */
+Move parseUciMove(GameState *gamePtr, char *moveStr) {
+    int length = strlen(moveStr);
+    if(length < 4 || length > 5 ||
+       moveStr[0] < 'a' || moveStr[0] > 'h' || moveStr[1] < '1' || moveStr[1] > '8' ||
+       moveStr[2] < 'a' || moveStr[2] > 'h' || moveStr[3] < '1' || moveStr[3] > '8')
+        return NO_MOVE;
+    if(length == 5 && strchr("nbrq", moveStr[4]) == NULL)
+        return NO_MOVE;
+
+    Move move = parseMove(gamePtr, moveStr);
+    return moveIsLegal(gamePtr, move) ? move : NO_MOVE;
+}
+
+/*
+ * move to string:
+ * writes move into moveStr as a coordinate pair, followed by the
+ * promotion piece if there is one (E.G. e2e4, a7a8q, e1g1 for a castle).
+ * moveStr needs room for 6 chars.
+ */
+void moveToString(Move move, char *moveStr) {
+    moveStr[0] = colToLetter(SQUARE_COL(MOVE_SOURCE(move)));
+    moveStr[1] = rowToLetter(SQUARE_ROW(MOVE_SOURCE(move)));
+    moveStr[2] = colToLetter(SQUARE_COL(MOVE_DEST(move)));
+    moveStr[3] = rowToLetter(SQUARE_ROW(MOVE_DEST(move)));
+    moveStr[4] = '\0';
+
+    if(MOVE_IS_PROMOTION(move)) {
+        moveStr[4] = pieceChar(MOVE_PROMOTION_TYPE(move), BLACK);
+        moveStr[5] = '\0';
+    }
+}
+
+/* squares of the same color as a8 (see hasInsufficientMaterial) */
+#define LIGHT_SQUARES 0xAA55AA55AA55AA55ULL
+
+/* ranks 8 and 1, where no pawn can stand (see positionIsLegal) */
+#define BACK_ROWS 0xFF000000000000FFULL
+
+/*
+ * init history:
+ * empties *historyPtr, then records gamePtr as its first position
+ */
+void initHistory(PositionHistory *historyPtr, GameState *gamePtr) {
+    historyPtr->count = 0;
+    pushPosition(historyPtr, gamePtr->hash);
+}
+
+/*
+ * push position:
+ * records the position a move has just reached (by its hash)
+ */
+void pushPosition(PositionHistory *historyPtr, unsigned long long hash) {
+    historyPtr->hashes[historyPtr->count & (HISTORY_SIZE - 1)] = hash;
+    historyPtr->count++;
+}
+
+/*
+ * pop position:
+ * forgets the last position pushed (when its move is unmade)
+ */
+void popPosition(PositionHistory *historyPtr) {
+    historyPtr->count--;
+}
+
+/*
+ * repetition count:
+ * how many times gamePtr (the last position pushed) occurred before.
+ * a capture or pawn move can never be undone, so only the positions
+ * since the last one (halfmoveClock plies) are compared, and only
+ * every other one of those, with the same side to move.
+ */
+int repetitionCount(PositionHistory *historyPtr, GameState *gamePtr) {
+    int current = historyPtr->count - 1;
+    int oldest = current - gamePtr->halfmoveClock;
+    if(oldest < current - (HISTORY_SIZE - 1))
+        oldest = current - (HISTORY_SIZE - 1); /* overwritten by now */
+    if(oldest < 0)
+        oldest = 0;
+
+    int repetitions = 0;
+    for(int i = current - 2; i >= oldest; i -= 2) {
+        if(historyPtr->hashes[i & (HISTORY_SIZE - 1)] == gamePtr->hash)
+            repetitions++;
+    }
+    return repetitions;
+}
+
+/*
+ * has insufficient material:
+ * checks whether neither side can ever checkmate: bare kings,
+ * a single knight or bishop, or only bishops all on one color of square
+ */
+int hasInsufficientMaterial(GameState *gamePtr) {
+    Bitboard (*pieces)[6] = gamePtr->pieceBoards;
+    if(pieces[WHITE][PAWN] | pieces[BLACK][PAWN] | pieces[WHITE][ROOK] |
+       pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN])
+        return FALSE;
+
+    Bitboard knights = pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT];
+    Bitboard bishops = pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP];
+    if(__builtin_popcountll(knights | bishops) <= 1)
+        return TRUE;
+
+    return knights == 0 && ((bishops & LIGHT_SQUARES) == 0 || 
+                            (bishops & ~LIGHT_SQUARES) == 0);
+}
+
+/*
+ * position is legal:
+ * checks what move generation relies on in a position that was not
+ * reached by playing moves (E.G. one loaded from a fen or an archive):
+ * each side has exactly one king and at most 16 pieces, no pawns are on
+ * the back ranks, and the side that just moved is not left in check
+ * (its king could be captured).
+ */
+int positionIsLegal(GameState *gamePtr) {
+    for(int color = BLACK; color <= WHITE; color++) {
+        if(__builtin_popcountll(gamePtr->pieceBoards[color][KING]) != 1 ||
+           __builtin_popcountll(gamePtr->colorBoards[color]) > 16 ||
+           (gamePtr->pieceBoards[color][PAWN] & BACK_ROWS))
+            return FALSE;
+    }
+
+    int waiting = !gamePtr->turn;
+    int kingSquare = __builtin_ctzll(gamePtr->pieceBoards[waiting][KING]);
+    return !squareIsAttacked(gamePtr, kingSquare, gamePtr->turn);
+}
+
+/*
+ * draw status:
+ * checks for the draws that do not depend on the legal moves:
+ * the fifty-move rule (a hundred plies without a capture or pawn move),
+ * insufficient material, and (if historyPtr is not NULL) a position
+ * repeated three times. draws are applied as soon as they can be claimed.
+ * returns CONTINUE (none), FIFTY_MOVE_DRAW, MATERIAL_DRAW or REPETITION_DRAW
+ */
+int drawStatus(GameState *gamePtr, PositionHistory *historyPtr) {
+    if(gamePtr->halfmoveClock >= 100)
+        return FIFTY_MOVE_DRAW;
+    if(hasInsufficientMaterial(gamePtr))
+        return MATERIAL_DRAW;
+    if(historyPtr != NULL && repetitionCount(historyPtr, gamePtr) >= 2)
+        return REPETITION_DRAW;
+    return CONTINUE;
+}
+
+/*
+ * game status:
+ * checks whether the side to move has been checkmated or stalemated,
+ * or the game is drawn (see drawStatus; historyPtr may be NULL).
+ * returns CONTINUE (neither), WHITE_CHECKMATE or BLACK_CHECKMATE
+ * (named for the winner), STALEMATE, or the drawStatus()
+ */
+int gameStatus(GameState *gamePtr, PositionHistory *historyPtr) {
+    MoveList legalMoves;
+    if(getAllLegalMoves(gamePtr, &legalMoves, gamePtr->turn) > 0)
+        return drawStatus(gamePtr, historyPtr);
+
+    if(isKingInCheck(gamePtr, gamePtr->turn)) {
+        return (gamePtr->turn == BLACK) ? WHITE_CHECKMATE : BLACK_CHECKMATE;
+    }
+    return STALEMATE;
+}
+
+/*
+ * status name:
+ * describes a gameStatus() value (E.G. "checkmate", "fifty-move rule")
+ */
+const char *statusName(int status) {
+    switch(status) {
+        case WHITE_CHECKMATE:
+        case BLACK_CHECKMATE:
+            return "checkmate";
+        case STALEMATE:
+            return "stalemate";
+        case FIFTY_MOVE_DRAW:
+            return "fifty-move rule";
+        case REPETITION_DRAW:
+            return "threefold repetition";
+        case MATERIAL_DRAW:
+            return "insufficient material";
+    }
+    return "ongoing";
+}
+
+/*
+ * castling rights that survive a move from or to each square
+ * (moving or capturing a king or rook gives up its castles)
+ */
+int castlingRightsKept(int square) {
+    switch(square) {
+        case SQUARE(7, 0):
+            return ALL_CASTLING_RIGHTS & ~WHITE_QUEEN_SIDE;
+        case SQUARE(7, 4):
+            return ALL_CASTLING_RIGHTS & ~(WHITE_KING_SIDE | WHITE_QUEEN_SIDE);
+        case SQUARE(7, 7):
+            return ALL_CASTLING_RIGHTS & ~WHITE_KING_SIDE;
+        case SQUARE(0, 0):
+            return ALL_CASTLING_RIGHTS & ~BLACK_QUEEN_SIDE;
+        case SQUARE(0, 4):
+            return ALL_CASTLING_RIGHTS & ~(BLACK_KING_SIDE | BLACK_QUEEN_SIDE);
+        case SQUARE(0, 7):
+            return ALL_CASTLING_RIGHTS & ~BLACK_KING_SIDE;
+    }
+    return ALL_CASTLING_RIGHTS;
+}
+
+/*
+ * updates the castling rights, en passant square, move counters and hash
+ * for a move by color, which is about to be made (the pieces have not moved yet).
+ * the hash also switches sides here, since the move hands the turn over.
+ */
+void updateMoveState(GameState *gamePtr, Move move, int color) {
+    int source = MOVE_SOURCE(move);
+    int dest = MOVE_DEST(move);
+
+    /* castling rights */
+    int newRights = gamePtr->castlingRights & castlingRightsKept(source) & 
+                    castlingRightsKept(dest);
+    gamePtr->hash ^= castlingKeys[gamePtr->castlingRights] ^ 
+                     castlingKeys[newRights];
+    gamePtr->castlingRights = newRights;
+
+    /* en passant square: only set if an enemy pawn could capture there */
+    if(gamePtr->enPassantSquare != NO_SQUARE) {
+        gamePtr->hash ^= enPassantKeys[SQUARE_COL(gamePtr->enPassantSquare)];
+        gamePtr->enPassantSquare = NO_SQUARE;
+    }
+    char movingPiece = gamePtr->board[SQUARE_ROW(source)][SQUARE_COL(source)];
+    if(pieceType(movingPiece) == PAWN && abs(dest - source) == 16) {
+        int passedSquare = (source + dest) / 2;
+        if(pawnAttacks(passedSquare, color) & gamePtr->pieceBoards[!color][PAWN]) {
+            gamePtr->enPassantSquare = passedSquare;
+            gamePtr->hash ^= enPassantKeys[SQUARE_COL(passedSquare)];
+        }
+    }
+
+    /* move counters */
+    char capturedPiece = gamePtr->board[SQUARE_ROW(dest)][SQUARE_COL(dest)];
+    if(pieceType(movingPiece) == PAWN || capturedPiece != ' ') {
+        gamePtr->halfmoveClock = 0;
+    } else {
+        gamePtr->halfmoveClock++;
+    }
+    if(color == BLACK)
+        gamePtr->fullmoveNumber++;
+
+    gamePtr->hash ^= blackToMoveKey;
+}
+
+/*
+ * moves the rook of the castle whose king goes to kingDest
+ * (or moves it back, if unmake)
+ */
+void moveCastleRook(GameState *gamePtr, int kingDest, int unmake) {
+    int row = SQUARE_ROW(kingDest);
+    int rookCol = (SQUARE_COL(kingDest) == 6) ? 7 : 0; /* king side : queen side */
+    int rookDestCol = (SQUARE_COL(kingDest) == 6) ? 5 : 3;
+
+    if(unmake) {
+        setSquare(gamePtr, row, rookCol, gamePtr->board[row][rookDestCol]);
+        setSquare(gamePtr, row, rookDestCol, ' ');
+    } else {
+        setSquare(gamePtr, row, rookDestCol, gamePtr->board[row][rookCol]);
+        setSquare(gamePtr, row, rookCol, ' ');
+    }
+}
+
+/*
+ * make move:
+ * plays move (encoded, and legal) for the side to move, updating the
+ * board, bitboards, castling rights, en passant square, move counters,
+ * hash and evaluation, and hands the turn over.
+ * fills in *undoPtr (to be passed into unmakeMove), unless it is NULL.
+ */
+void makeMove(GameState *gamePtr, Move move, UndoInfo *undoPtr) {
+    int sourceRow = SQUARE_ROW(MOVE_SOURCE(move));
+    int sourceCol = SQUARE_COL(MOVE_SOURCE(move));
+    int destRow = SQUARE_ROW(MOVE_DEST(move));
+    int destCol = SQUARE_COL(MOVE_DEST(move));
+    int color = gamePtr->turn;
+
+    /* the pawn taken en passant is beside the source */
+    int capturedRow = (MOVE_FLAGS(move) == EN_PASSANT_FLAG) ? sourceRow : destRow;
+    char capturedPiece = gamePtr->board[capturedRow][destCol];
+
+    if(undoPtr) {
+        undoPtr->hash = gamePtr->hash;
+        undoPtr->capturedPiece = capturedPiece;
+        undoPtr->castlingRights = gamePtr->castlingRights;
+        undoPtr->enPassantSquare = gamePtr->enPassantSquare;
+        undoPtr->halfmoveClock = gamePtr->halfmoveClock;
+    }
+
+    updateMoveState(gamePtr, move, color);
+
+    char movingPiece = gamePtr->board[sourceRow][sourceCol];
+    if(MOVE_IS_PROMOTION(move)) {
+        movingPiece = pieceChar(MOVE_PROMOTION_TYPE(move), color);
+    } else if(MOVE_FLAGS(move) == CASTLE_FLAG) {
+        moveCastleRook(gamePtr, MOVE_DEST(move), FALSE);
+    }
+
+    if(MOVE_FLAGS(move) == EN_PASSANT_FLAG)
+        setSquare(gamePtr, capturedRow, destCol, ' ');
+    setSquare(gamePtr, destRow, destCol, movingPiece); 
+    setSquare(gamePtr, sourceRow, sourceCol, ' ');
+
+    gamePtr->turn = !color;
+}
+
+/*
+ * unmake move:
+ * takes back move, the last move made on gamePtr,
+ * with the *undoPtr that makeMove filled in.
+ */
+void unmakeMove(GameState *gamePtr, Move move, UndoInfo *undoPtr) {
+    int sourceRow = SQUARE_ROW(MOVE_SOURCE(move));
+    int sourceCol = SQUARE_COL(MOVE_SOURCE(move));
+    int destRow = SQUARE_ROW(MOVE_DEST(move));
+    int destCol = SQUARE_COL(MOVE_DEST(move));
+    int color = !gamePtr->turn;
+
+    char movedPiece = gamePtr->board[destRow][destCol];
+    if(MOVE_IS_PROMOTION(move)) {
+        movedPiece = pieceChar(PAWN, color);
+    } else if(MOVE_FLAGS(move) == CASTLE_FLAG) {
+        moveCastleRook(gamePtr, MOVE_DEST(move), TRUE);
+    }
+
+    setSquare(gamePtr, sourceRow, sourceCol, movedPiece);
+    if(MOVE_FLAGS(move) == EN_PASSANT_FLAG) {
+        setSquare(gamePtr, destRow, destCol, ' ');
+        setSquare(gamePtr, sourceRow, destCol, undoPtr->capturedPiece);
+    } else {
+        setSquare(gamePtr, destRow, destCol, undoPtr->capturedPiece);
+    }
+
+    gamePtr->turn = color;
+    gamePtr->castlingRights = undoPtr->castlingRights;
+    gamePtr->enPassantSquare = undoPtr->enPassantSquare;
+    gamePtr->halfmoveClock = undoPtr->halfmoveClock;
+    if(color == BLACK)
+        gamePtr->fullmoveNumber--;
+
+    /* setSquare has been changing the hash: the saved one is simply put back */
+    gamePtr->hash = undoPtr->hash;
+}
+
+/*
+ * checks if move is legal (based on the board)
+ */
+int moveIsLegal(GameState *gamePtr, Move move) {
+    int sourceRow = SQUARE_ROW(MOVE_SOURCE(move));
+    int sourceCol = SQUARE_COL(MOVE_SOURCE(move));
+
+    /* make sure piece matches player color */
+    char pieceType = gamePtr->board[sourceRow][sourceCol];
+    if(pieceType == ' ' || (pieceIsWhite(pieceType) != gamePtr->turn )) {
+        return FALSE;
+    }
+
+    /* get pieceLegalMoves */
+    MoveList possiblePieceMoves;
+    int numPieceMoves = getPieceLegalMoves(gamePtr, &possiblePieceMoves, 
+                                           sourceRow, sourceCol); 
+
+    for(int i = 0; i < numPieceMoves; i++) {
+        if(possiblePieceMoves.moves[i] == move) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,152 @@
+#include "core.h"
+
+/*
+ * a pool hands out games from slabs of POOL_SLAB_GAMES, so hosting many
+ * games costs one allocation per slab rather than one per game, and a game
+ * never moves once it has a slot (pointers to it stay valid).
+ *
+ * a game's id is its slot in the low 32 bits, and the slot's generation
+ * in the high bits: the generation is bumped whenever a game ends,
+ * so the id of an ended game never finds the game that reuses its slot.
+ */
+#define ID_SLOT(id) ((int) ((id) & 0xFFFFFFFF))
+#define ID_GENERATION(id) ((unsigned int) ((id) >> 32))
+#define MAKE_ID(slot, generation) (((long long) (generation) << 32) | (slot))
+
+/*
+ * allocates size bytes aligned to a cache line (PooledGame's alignment)
+ */
+void *allocAligned(size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, CACHE_LINE_SIZE);
+#else
+    void *memory;
+    return posix_memalign(&memory, CACHE_LINE_SIZE, size) == 0 ? memory : NULL;
+#endif
+}
+
+void freeAligned(void *memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+/*
+ * sets up an empty pool (slabs are allocated as games are added)
+ */
+void initGamePool(GamePool *poolPtr) {
+    poolPtr->slabs = NULL;
+    poolPtr->numSlabs = 0;
+    poolPtr->firstFree = -1;
+    poolPtr->numGames = 0;
+}
+
+/*
+ * the game in a slot (which must be below numSlabs * POOL_SLAB_GAMES)
+ */
+PooledGame *poolSlot(GamePool *poolPtr, int slot) {
+    return &poolPtr->slabs[slot / POOL_SLAB_GAMES][slot % POOL_SLAB_GAMES];
+}
+
+/*
+ * adds a slab of free games to the pool.
+ * returns FALSE if it could not be allocated.
+ */
+int addSlab(GamePool *poolPtr) {
+    if((long long) (poolPtr->numSlabs + 1) * POOL_SLAB_GAMES > 0x7FFFFFFF)
+        return FALSE;
+
+    PooledGame **slabs = realloc(poolPtr->slabs, (poolPtr->numSlabs + 1) * sizeof(PooledGame *));
+    if(slabs == NULL)
+        return FALSE;
+    poolPtr->slabs = slabs;
+
+    PooledGame *slab = allocAligned(POOL_SLAB_GAMES * sizeof(PooledGame));
+    if(slab == NULL)
+        return FALSE;
+    poolPtr->slabs[poolPtr->numSlabs] = slab;
+
+    /* thread the new slots onto the free list, lowest first */
+    int firstSlot = poolPtr->numSlabs * POOL_SLAB_GAMES;
+    for(int i = 0; i < POOL_SLAB_GAMES; i++) {
+        slab[i].generation = 0;
+        slab[i].inUse = FALSE;
+        slab[i].nextFree = (i + 1 < POOL_SLAB_GAMES) ? firstSlot + i + 1 : poolPtr->firstFree;
+    }
+    poolPtr->firstFree = firstSlot;
+    poolPtr->numSlabs++;
+
+    return TRUE;
+}
+
+/*
+ * starts a game from the position in fen.
+ *
+ * returns:
+ * the new game's id, or -1 if fen is not valid or the pool could not grow
+ */
+long long newPoolGame(GamePool *poolPtr, const char *fen) {
+    if(poolPtr->firstFree < 0 && !addSlab(poolPtr))
+        return -1;
+
+    int slot = poolPtr->firstFree;
+    PooledGame *pooledPtr = poolSlot(poolPtr, slot);
+    if(!loadFen(&pooledPtr->position, fen))
+        return -1; /* the slot is still free */
+
+    initHistory(&pooledPtr->history, &pooledPtr->position);
+    poolPtr->firstFree = pooledPtr->nextFree;
+    pooledPtr->inUse = TRUE;
+    pooledPtr->numMoves = 0;
+    poolPtr->numGames++;
+
+    return MAKE_ID(slot, pooledPtr->generation);
+}
+
+/*
+ * returns:
+ * the game with id, or NULL if there is none (or it has ended)
+ */
+PooledGame *poolGame(GamePool *poolPtr, long long id) {
+    if(id < 0)
+        return NULL;
+
+    int slot = ID_SLOT(id);
+    if(slot >= poolPtr->numSlabs * POOL_SLAB_GAMES)
+        return NULL;
+
+    PooledGame *pooledPtr = poolSlot(poolPtr, slot);
+    if(!pooledPtr->inUse || pooledPtr->generation != ID_GENERATION(id))
+        return NULL;
+    return pooledPtr;
+}
+
+/*
+ * ends the game with id, freeing its slot for another game.
+ * returns FALSE if there is no such game.
+ */
+int endPoolGame(GamePool *poolPtr, long long id) {
+    PooledGame *pooledPtr = poolGame(poolPtr, id);
+    if(pooledPtr == NULL)
+        return FALSE;
+
+    pooledPtr->inUse = FALSE;
+    pooledPtr->generation = (pooledPtr->generation + 1) & 0x7FFFFFFF; /* ids stay positive */
+    pooledPtr->nextFree = poolPtr->firstFree;
+    poolPtr->firstFree = ID_SLOT(id);
+    poolPtr->numGames--;
+
+    return TRUE;
+}
+
+/*
+ * frees every slab of the pool (ending all of its games)
+ */
+void freeGamePool(GamePool *poolPtr) {
+    for(int i = 0; i < poolPtr->numSlabs; i++)
+        freeAligned(poolPtr->slabs[i]);
+    free(poolPtr->slabs);
+    initGamePool(poolPtr);
+}
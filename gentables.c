@@ -0,0 +1,376 @@
+#include "core.h"
+
+/*
+ * gentables:
+ * computes the attack tables, magic numbers and zobrist keys, and
+ * prints them as C source (tables.c), so that they are constant data
+ * in the program and nothing has to be set up at startup.
+ * the build runs it before compiling the library.
+ */
+
+#define FILE_A 0x0101010101010101ULL
+#define FILE_B (FILE_A << 1)
+#define FILE_G (FILE_A << 6)
+#define FILE_H (FILE_A << 7)
+
+/*
+ * one-square shifts of every bit in a bitboard.
+ * north is towards row 0 (black's side), east is towards col 7 (the h file).
+ */
+#define NORTH(b) ((b) >> 8)
+#define SOUTH(b) ((b) << 8)
+#define EAST(b) (((b) << 1) & ~FILE_A)
+#define WEST(b) (((b) >> 1) & ~FILE_H)
+
+#define ROOK_TABLE_SIZE 102400 /* every square's slice, back to back */
+#define BISHOP_TABLE_SIZE 5248
+
+/*
+ * everything that goes into tables.c
+ */
+typedef struct _tables {
+    Bitboard knightAttacks[64];
+    Bitboard kingAttacks[64];
+    Bitboard pawnAttacks[2][64];
+    Bitboard between[64][64];
+    Bitboard line[64][64];
+    Magic rookMagics[64];
+    Magic bishopMagics[64];
+    Bitboard rookAttacks[ROOK_TABLE_SIZE];
+    Bitboard bishopAttacks[BISHOP_TABLE_SIZE];
+
+    unsigned long long pieceKeys[2][6][64];
+    unsigned long long castlingKeys[16];
+    unsigned long long enPassantKeys[8];
+    unsigned long long blackToMoveKey;
+} Tables;
+
+Tables tables;
+
+/*
+ * walks from square in the (rOffset, cOffset) direction,
+ * collecting squares up to and including the first occupied one.
+ */
+Bitboard rayAttacks(int square, Bitboard occupied, int rOffset, int cOffset) {
+    Bitboard attacks = 0;
+
+    int r = SQUARE_ROW(square) + rOffset;
+    int c = SQUARE_COL(square) + cOffset;
+    while(r >= 0 && r < 8 && c >= 0 && c < 8) {
+        Bitboard bit = SQUARE_BIT(SQUARE(r, c));
+        attacks |= bit;
+        if(occupied & bit)
+            break;
+
+        r += rOffset;
+        c += cOffset;
+    }
+
+    return attacks;
+}
+
+/*
+ * squares a slider on square attacks along the directions in offsets,
+ * by walking each ray
+ */
+Bitboard slowSliderAttacks(int square, Bitboard occupied, const int offsets[4][2]) {
+    Bitboard attacks = 0;
+    for(int i = 0; i < 4; i++) {
+        attacks |= rayAttacks(square, occupied, offsets[i][0], offsets[i][1]);
+    }
+    return attacks;
+}
+
+/*
+ * a random number with few bits set (these make good magic candidates),
+ * from the xorshift64* generator with state *statePtr
+ */
+Bitboard sparseRandom(unsigned long long *statePtr) {
+    Bitboard result = ~0ULL;
+
+    for(int i = 0; i < 3; i++) {
+        *statePtr ^= *statePtr >> 12;
+        *statePtr ^= *statePtr << 25;
+        *statePtr ^= *statePtr >> 27;
+        result &= *statePtr * 2685821657736338717ULL;
+    }
+    return result;
+}
+
+/*
+ * finds a magic number for square (drawing candidates from the
+ * generator state *seedPtr), and fills in its slice of the attack table
+ * (starting at table). returns the slice's size.
+ */
+int initMagic(Magic *magicPtr, Bitboard *table, int square,
+              const int offsets[4][2], unsigned long long *seedPtr) {
+    static Bitboard occupancies[4096];
+    static Bitboard attacks[4096];
+    static int attempts[4096]; /* which attempt last wrote each table entry */
+
+    /* the mask: rays from square, less the farthest square of each */
+    Bitboard mask = 0;
+    for(int i = 0; i < 4; i++) {
+        Bitboard ray = rayAttacks(square, 0, offsets[i][0], offsets[i][1]);
+        if(ray == 0)
+            continue;
+
+        int towardsH1 = offsets[i][0] * 8 + offsets[i][1] > 0;
+        Bitboard farthest = towardsH1 ? SQUARE_BIT(63 - __builtin_clzll(ray))
+                                      : (ray & -ray);
+        mask |= ray & ~farthest;
+    }
+
+    /* every subset of the mask (carry-rippler), and its attacks */
+    int size = 0;
+    Bitboard subset = 0;
+    do {
+        occupancies[size] = subset;
+        attacks[size] = slowSliderAttacks(square, subset, offsets);
+        attempts[size] = 0;
+        size++;
+        subset = (subset - mask) & mask;
+    } while(subset);
+
+    magicPtr->mask = mask;
+    magicPtr->attacks = table;
+    magicPtr->shift = 64 - __builtin_popcountll(mask);
+
+    /* try magics until no two occupancies with different attacks collide */
+    for(int attempt = 1;; attempt++) {
+        magicPtr->magic = sparseRandom(seedPtr);
+        if(__builtin_popcountll((mask * magicPtr->magic) >> 56) < 6)
+            continue;
+
+        int i;
+        for(i = 0; i < size; i++) {
+            int index = (occupancies[i] * magicPtr->magic) >> magicPtr->shift;
+            if(attempts[index] < attempt) {
+                attempts[index] = attempt;
+                table[index] = attacks[i];
+            } else if(table[index] != attacks[i]) {
+                break;
+            }
+        }
+        if(i == size)
+            return size;
+    }
+}
+
+/*
+ * finds the direction from square a to square b.
+ * returns FALSE if they do not share a row, column or diagonal.
+ */
+int squaresAlign(int a, int b, int *rOffsetPtr, int *cOffsetPtr) {
+    int rDiff = SQUARE_ROW(b) - SQUARE_ROW(a);
+    int cDiff = SQUARE_COL(b) - SQUARE_COL(a);
+
+    if(a == b || (rDiff != 0 && cDiff != 0 && abs(rDiff) != abs(cDiff)))
+        return FALSE;
+
+    *rOffsetPtr = (rDiff > 0) - (rDiff < 0);
+    *cOffsetPtr = (cDiff > 0) - (cDiff < 0);
+    return TRUE;
+}
+
+/*
+ * fills in the attack tables and finds the magic numbers
+ */
+void initAttackTables(Tables *tablesPtr) {
+    static const int rookOffsets[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+    static const int bishopOffsets[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+    /*
+     * the magic search restarts from a fixed seed on each row: of the first
+     * few thousand seeds, these find the row's magics in the fewest tries.
+     */
+    static const unsigned long long rookSeeds[8] = {
+        1776, 1387, 1053, 2719, 2271, 2078, 974, 30
+    };
+    static const unsigned long long bishopSeeds[8] = {
+        2514, 1421, 2450, 1425, 1053, 2402, 383, 1586
+    };
+    unsigned long long rookSeed = 0, bishopSeed = 0;
+
+    Bitboard *rookSlice = tablesPtr->rookAttacks;
+    Bitboard *bishopSlice = tablesPtr->bishopAttacks;
+
+    for(int square = 0; square < 64; square++) {
+        Bitboard bit = SQUARE_BIT(square);
+        if(SQUARE_COL(square) == 0) {
+            rookSeed = rookSeeds[SQUARE_ROW(square)];
+            bishopSeed = bishopSeeds[SQUARE_ROW(square)];
+        }
+
+        Bitboard oneCol = EAST(bit) | WEST(bit);
+        Bitboard twoCols = ((bit << 2) & ~(FILE_A | FILE_B)) |
+                           ((bit >> 2) & ~(FILE_G | FILE_H));
+        tablesPtr->knightAttacks[square] = (oneCol << 16) | (oneCol >> 16) |
+                                           (twoCols << 8) | (twoCols >> 8);
+
+        Bitboard row = bit | EAST(bit) | WEST(bit);
+        tablesPtr->kingAttacks[square] = (row | NORTH(row) | SOUTH(row)) & ~bit;
+
+        tablesPtr->pawnAttacks[WHITE][square] = EAST(NORTH(bit)) | WEST(NORTH(bit));
+        tablesPtr->pawnAttacks[BLACK][square] = EAST(SOUTH(bit)) | WEST(SOUTH(bit));
+
+        rookSlice += initMagic(&tablesPtr->rookMagics[square], rookSlice, square,
+                               rookOffsets, &rookSeed);
+        bishopSlice += initMagic(&tablesPtr->bishopMagics[square], bishopSlice,
+                                 square, bishopOffsets, &bishopSeed);
+
+        for(int other = 0; other < 64; other++) {
+            int rOffset, cOffset;
+            if(!squaresAlign(square, other, &rOffset, &cOffset))
+                continue;
+
+            /* the ray from square stops at other, so other is the only extra square */
+            tablesPtr->between[square][other] =
+                rayAttacks(square, SQUARE_BIT(other), rOffset, cOffset) &
+                ~SQUARE_BIT(other);
+            tablesPtr->line[square][other] =
+                rayAttacks(square, 0, rOffset, cOffset) |
+                rayAttacks(square, 0, -rOffset, -cOffset) | bit;
+        }
+    }
+}
+
+/*
+ * returns the next number of a xorshift generator.
+ * the seed is fixed, so hashes are the same from build to build.
+ */
+unsigned long long nextRandomKey() {
+    static unsigned long long state = 0x9E3779B97F4A7C15ULL;
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/*
+ * fills in the zobrist keys: a position's hash is the xor of one random
+ * key per (piece, square), plus keys for its castling rights,
+ * en passant file, and black to move.
+ */
+void initZobristKeys(Tables *tablesPtr) {
+    for(int color = 0; color < 2; color++) {
+        for(int type = 0; type < 6; type++) {
+            for(int square = 0; square < 64; square++) {
+                tablesPtr->pieceKeys[color][type][square] = nextRandomKey();
+            }
+        }
+    }
+
+    /* each right gets a key, and a set of rights is the xor of its keys */
+    unsigned long long rightKeys[4];
+    for(int i = 0; i < 4; i++) {
+        rightKeys[i] = nextRandomKey();
+    }
+    for(int rights = 0; rights < 16; rights++) {
+        tablesPtr->castlingKeys[rights] = 0;
+        for(int i = 0; i < 4; i++) {
+            if(rights & (1 << i))
+                tablesPtr->castlingKeys[rights] ^= rightKeys[i];
+        }
+    }
+
+    for(int col = 0; col < 8; col++) {
+        tablesPtr->enPassantKeys[col] = nextRandomKey();
+    }
+
+    tablesPtr->blackToMoveKey = nextRandomKey();
+}
+
+/*
+ * prints count numbers as the body of an array initializer,
+ * four to a line, each line starting with indent
+ */
+void printNumbers(FILE *file, const unsigned long long *numbers, int count,
+                  const char *indent) {
+    for(int i = 0; i < count; i++) {
+        fprintf(file, "%s0x%016llxULL,%s", (i % 4 == 0) ? indent : "", numbers[i],
+                (i % 4 == 3 || i == count - 1) ? "\n" : " ");
+    }
+}
+
+/*
+ * prints the array name[numArrays][count] (or name[count] if numArrays is 0)
+ */
+void printArray(FILE *file, const char *type, const char *name,
+                const unsigned long long *numbers, int numArrays, int count) {
+    if(numArrays == 0) {
+        fprintf(file, "const %s %s[%d] = {\n", type, name, count);
+        printNumbers(file, numbers, count, "    ");
+    } else {
+        fprintf(file, "const %s %s[%d][%d] = {\n", type, name, numArrays, count);
+        for(int i = 0; i < numArrays; i++) {
+            fprintf(file, "    {\n");
+            printNumbers(file, numbers + i * count, count, "        ");
+            fprintf(file, "    },\n");
+        }
+    }
+    fprintf(file, "};\n\n");
+}
+
+/*
+ * prints the magics of one slider, pointing into its attack table tableName
+ */
+void printMagics(FILE *file, const char *name, const Magic *magics,
+                 const Bitboard *table, const char *tableName) {
+    fprintf(file, "const Magic %s[64] = {\n", name);
+    for(int square = 0; square < 64; square++) {
+        fprintf(file, "    {0x%016llxULL, 0x%016llxULL, %s + %d, %d},\n",
+                magics[square].mask, magics[square].magic, tableName,
+                (int) (magics[square].attacks - table), magics[square].shift);
+    }
+    fprintf(file, "};\n\n");
+}
+
+/*
+ * usage:
+ *     gentables > tables.c
+ */
+int main() {
+    FILE *file = stdout;
+    initAttackTables(&tables);
+    initZobristKeys(&tables);
+
+    fprintf(file, "/* generated by gentables.c: do not edit */\n\n");
+    fprintf(file, "#include \"core.h\"\n\n");
+
+    printArray(file, "Bitboard", "knightAttackTable", tables.knightAttacks, 0, 64);
+    printArray(file, "Bitboard", "kingAttackTable", tables.kingAttacks, 0, 64);
+    printArray(file, "Bitboard", "pawnAttackTable", tables.pawnAttacks[0], 2, 64);
+    printArray(file, "Bitboard", "betweenTable", tables.between[0], 64, 64);
+    printArray(file, "Bitboard", "lineTable", tables.line[0], 64, 64);
+    printArray(file, "Bitboard", "rookAttackTable", tables.rookAttacks, 0,
+               ROOK_TABLE_SIZE);
+    printArray(file, "Bitboard", "bishopAttackTable", tables.bishopAttacks, 0,
+               BISHOP_TABLE_SIZE);
+    printMagics(file, "rookMagics", tables.rookMagics, tables.rookAttacks,
+                "rookAttackTable");
+    printMagics(file, "bishopMagics", tables.bishopMagics, tables.bishopAttacks,
+                "bishopAttackTable");
+
+    fprintf(file, "const unsigned long long pieceKeys[2][6][64] = {\n");
+    for(int color = 0; color < 2; color++) {
+        fprintf(file, "    {\n");
+        for(int type = 0; type < 6; type++) {
+            fprintf(file, "        {\n");
+            printNumbers(file, tables.pieceKeys[color][type], 64, "            ");
+            fprintf(file, "        },\n");
+        }
+        fprintf(file, "    },\n");
+    }
+    fprintf(file, "};\n\n");
+
+    printArray(file, "unsigned long long", "castlingKeys", tables.castlingKeys,
+               0, 16);
+    printArray(file, "unsigned long long", "enPassantKeys", tables.enPassantKeys,
+               0, 8);
+    fprintf(file, "const unsigned long long blackToMoveKey = 0x%016llxULL;\n",
+            tables.blackToMoveKey);
+
+    return ferror(file) ? 1 : 0;
+}
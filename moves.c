@@ -1,450 +1,565 @@
-#include "chess.h"
-
-#define COLLISION 0
-#define NO_COLLISION 1
-
-/*
- * contains the current
- * and destination coordinates
- * of a moving piece
- */
-typedef struct _moveConjecture {
-    /* current location */
-    int row;
-    int col;
-
-    /* destination */
-    int dRow;
-    int dCol;
-
-    char pieceName;
-} MoveConjecture;
-
-
-/*
- * allocates space for a copy of moveStr,
- * and returns a pointer to that copy
- */
-char *newMove(const char *moveToCopy) {
-    char *movePtr = malloc(strlen(moveToCopy) + 1);
-    strcpy(movePtr, moveToCopy);
-
-    return movePtr;
-}
-
-
-/*
- * translates a MoveConjecture to a string
- * that represents the move.
- */
-char *getMoveStr(MoveConjecture move) {
-    static char moveStr[] = "    ";
-
-    /* moveStr[0:1] = source coord */
-    moveStr[0] = colToLetter(move.col);
-    moveStr[1] = rowToLetter(move.row); 
-
-    /* moveStr[2:3] = destination coord */
-    moveStr[2] = colToLetter(move.dCol);
-    moveStr[3] = rowToLetter(move.dRow); 
-
-    return moveStr;
-}
-
-/* 
- * global: moveType- holds the move's collision status (
- * NO_COLLISION or COLLISION
- */ 
-int moveType;
-
-/**
- * noCollision:
- * checks if destinationPiece is blank,
- * sets moveType accordingly
- *
- * recieves:
- * destinationPiece, movingPiece
- *
- * returns
- * collision?
- */
-int noCollision(char destinationPiece, char movingPiece) {
-    return (moveType = destinationPiece == ' ');    
-}
-
-/*
- * returns TRUE if destinationPiece is has
- * a different color (case) than movingPiece.
- * sets moveType accordingly
- */
-int onlyUnfriendlyCollision(char destinationPiece, char movingPiece) {
-    if(moveType = destinationPiece == ' ') {
-        return FALSE;
-    }
-
-    int isWhite = pieceIsWhite(movingPiece);    
-    int destIsWhite = pieceIsWhite(destinationPiece);    
-
-    return (isWhite != destIsWhite);
-}
-
-/*
- * returns TRUE if destinationPiece is ' ' or has
- * a different color (case) than movingPiece.
- * sets moveType accordingly
- */
-int noFriendlyCollision(char destinationPiece, char movingPiece) {
-    if(moveType = destinationPiece == ' ') {
-        return TRUE;
-    }
-
-    int isWhite = pieceIsWhite(movingPiece);    
-    int destIsWhite = pieceIsWhite(destinationPiece);    
-
-    if(isWhite != destIsWhite) { /* unfriendly collision */
-        return TRUE;
-    }
-    
-    /* friendly collision */
-    return FALSE;
-}
-
-/*
- * adds move to moveArr (incrementing numMovesPtr) if condition is met.
- * (according to the sate of gamePtr)
- */
-void conditionalAddMove(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-                        MoveConjecture move, int (* condition)(char, char)) {
-    if(condition(gamePtr->board[move.dRow][move.dCol], move.pieceName)) {
-        moveArr[(*numMovesPtr)++] = newMove(getMoveStr(move)); /* add move */
-    }
-}
-
-
-/*
- * finds moves that can be made by the pawn
- * whose position is refered to by move.
- * adds those moves to moveArr, and adjusts numMovesPtr accordingly.
- */
-void pawnMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-               MoveConjecture move) {
-
-    int isWhite = pieceIsWhite(move.pieceName);
-    int canDoubleJump = (!isWhite && move.row == 1) || 
-                        (isWhite && move.row == 6);
-    int regularJump = (isWhite) ? -1 : 1;
-
-    move.dCol = move.col;
-
-    /* double jump */
-    move.dRow = move.row + 2 * regularJump;
-    if(canDoubleJump) {
-        conditionalAddMove(gamePtr, moveArr, numMovesPtr, move, noCollision);
-    }
-
-    /* single jump */
-    move.dRow = move.row + 1 * regularJump;
-    conditionalAddMove(gamePtr, moveArr, numMovesPtr, move, noCollision);
-
-
-    /* diagonal captures */
-    move.dCol = move.col + 1;
-    if(move.dCol < 8 && move.dCol >= 0)
-        conditionalAddMove(gamePtr, moveArr, numMovesPtr, move, 
-                           onlyUnfriendlyCollision);
-
-    move.dCol = move.col - 1;
-    if(move.dCol < 8 && move.dCol >= 0)
-        conditionalAddMove(gamePtr, moveArr, numMovesPtr, move, 
-                           onlyUnfriendlyCollision);
-}
-
-/*
- * repeatedly advances the piece (whose coordinate
- * is in move) in the direction (based on rOffest
- * and cOffset)- moves are added to moveArr until an invalid
- * move is reached. 
- */
-void repeatedDirectionalMove(GameState *gamePtr, char **moveArr, 
-                             int *numMovesPtr, MoveConjecture move, 
-                             int rOffset, int cOffset) {
-
-    int r = move.row + rOffset;
-    int c = move.col + cOffset;
-    while(r >= 0 && r < 8 && c >= 0 && c < 8) {
-        move.dRow = r;
-        move.dCol = c;
-        conditionalAddMove(gamePtr, moveArr, numMovesPtr, move, 
-                           noFriendlyCollision);
-        if(moveType != NO_COLLISION)
-            return;
-
-        r += rOffset;
-        c += cOffset;
-    }
-    
-}
-
-/*
- * finds moves that can be made by the rook
- * whose position is refered to by move.
- * adds those moves to moveArr, and adjusts numMovesPtr accordingly.
- */
-void rookMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-               MoveConjecture move) {
-    /* left */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, 0, -1);
-    /* right */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, 0, 1);
-    /* up */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, -1, 0);
-    /* down */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, 1, 0);
-}
-
-/*
- * finds moves that can be made by the knight
- * whose position is refered to by move.
- * adds those moves to moveArr, and adjusts numMovesPtr accordingly.
- */
-void knightMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-                 MoveConjecture move) {
-    int knightMoveOffsets[8][2] = {{1, 2}, {1, -2}, {2, 1}, {2, -1}, {-1, 2}, 
-                                   {-1, -2}, {-2, 1}, {-2, -1}};
-
-    for(int i = 0; i < 8; i++) {
-        move.dRow = move.row + knightMoveOffsets[i][0];
-        move.dCol = move.col + knightMoveOffsets[i][1];
-        if(move.dRow >= 0 && move.dRow < 8 && move.dCol >= 0 && 
-           move.dCol < 8){ /* move fits in board */
-            conditionalAddMove(gamePtr, moveArr, numMovesPtr, 
-                               move, noFriendlyCollision);
-        }
-    }
-}
-
-
-/*
- * finds moves that can be made by the bishop
- * whose position is refered to by move.
- * adds those moves to moveArr, and adjusts numMovesPtr accordingly.
- */
-void bishopMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-                 MoveConjecture move) {
-    /* northwest */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, -1, -1);
-    /* northeast */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, -1, 1);
-    /* southwest */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, 1, -1); 
-    /* southeast */
-    repeatedDirectionalMove(gamePtr, moveArr, numMovesPtr, move, 1, 1); 
-}
-
-/*
- * finds moves that can be made by the queen
- * whose position is refered to by move.
- * adds those moves to moveArr, and adjusts numMovesPtr accordingly.
- */
-void queenMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-                MoveConjecture move) {
-    rookMoves(gamePtr, moveArr, numMovesPtr, move);
-    bishopMoves(gamePtr, moveArr, numMovesPtr, move);
-}
-
-/*
- * finds moves that can be made by the king
- * whose position is refered to by move.
- * adds those moves to moveArr, and adjusts numMovesPtr accordingly.
- */
-void kingMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-               MoveConjecture move) {
-    int kingMoveOffsets[8][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}, 
-                                 {1 , 1}, {1, -1}, {-1, 1}, {-1, -1}};
-
-    for(int i = 0; i < 8; i++) {
-        move.dRow = move.row + kingMoveOffsets[i][0];
-        move.dCol = move.col + kingMoveOffsets[i][1];
-        if(move.dRow >= 0 && move.dRow < 8 && move.dCol >= 0 &&
-           move.dCol < 8) { /* move fits in board */
-            conditionalAddMove(gamePtr, moveArr, numMovesPtr, 
-                               move, noFriendlyCollision);
-        }
-    }
-}
-
-/*
- * gets all moves allowed (disregaurding checks) for a given piece,
- * according to the state of the board.
- */
-void getPieceMoves(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-                   int row, int col) {
-    /* set up possible move struct */
-    MoveConjecture possibleMove;
-    possibleMove.row = row;
-    possibleMove.col = col;
-    possibleMove.pieceName = gamePtr->board[row][col];
-
-
-    /* add all possible moves based on pieceType */
-    switch(tolower(possibleMove.pieceName)) {
-        case 'p':
-            return pawnMoves(gamePtr, moveArr, numMovesPtr, possibleMove);
-            break;
-        case 'r':
-            return rookMoves(gamePtr, moveArr, numMovesPtr, possibleMove);
-            break;
-        case 'n':
-            return knightMoves(gamePtr, moveArr, numMovesPtr, possibleMove);
-            break;
-        case 'b':
-            return bishopMoves(gamePtr, moveArr, numMovesPtr, possibleMove);
-            break;
-        case 'q':
-            return queenMoves(gamePtr, moveArr, numMovesPtr, possibleMove);
-            break;
-        case 'k':
-            return kingMoves(gamePtr, moveArr, numMovesPtr, possibleMove);
-            break;
-
-    }    
-}
-
-/*
- * is the castle of respective type and color a piece-legal move?
- */
-int canCastle(GameState *gamePtr, int color, int isKingSide) {
-    int piecesAlign;
-
-    int row = (color == WHITE) ? 7 : 0;
-    char king = (color == WHITE) ? 'K' : 'k';
-    char rook = (color == WHITE) ? 'R' : 'r'; 
-
-    if(isKingSide) {
-        piecesAlign = gamePtr->board[row][4] == king && 
-            gamePtr->board[row][7] == rook &&
-            gamePtr->board[row][5] == ' ' && gamePtr->board[row][6] == ' ';
-
-    } else {
-        piecesAlign = gamePtr->board[row][4] == king && 
-            gamePtr->board[row][0] == rook &&
-            gamePtr->board[row][5] == ' ' && gamePtr->board[row][6] == ' ';
-    }
-    return piecesAlign;
-}
-
-
-/*
- * checks for castle elegibility, and adds
- * the castles to moveArr accordingly.
- */
-void getCastles(GameState *gamePtr, char **moveArr, int *numMovesPtr, 
-                int color) {
-
-    if(canCastle(gamePtr, color, TRUE)) {
-        moveArr[(*numMovesPtr)++] = newMove(KING_SIDE_CASTLE);
-    }
-
-    if(canCastle(gamePtr, color, FALSE)) {
-        moveArr[(*numMovesPtr)++] = newMove(QUEEN_SIDE_CASTLE);
-    }
-}
-
-/*
- * gets all moves that are allowed (disregaurding checks) by a given color,
- * according to the state of the board
- */
-int getAllMoves(GameState *gamePtr, char **moveArr, int color) {
-    int numMoves = 0;
-    char piece;
-    for(int row = 0; row < 8; row++) {
-        for(int col = 0; col < 8; col++) {
-            piece = gamePtr->board[row][col];
-
-            if(piece != ' ' && pieceIsWhite(piece) == color) {
-                getPieceMoves(gamePtr, moveArr, &numMoves, row, col);
-            }
-        }
-    }
-
-    getCastles(gamePtr, moveArr, &numMoves, color);
-    return numMoves;
-}
-
-/*
- * is the king in check?
- */
-int isKingInCheck(GameState *gamePtr, int color) {
-    char **opposingMoves = malloc(150 * sizeof(char *));
-    int numOpposingMoves = getAllMoves(gamePtr, opposingMoves, !color);
-    char playersKing = (color == WHITE) ? 'K' : 'k';
-
-    int rDest, cDest;
-    for(int i = 0; i < numOpposingMoves; i++) {
-        cDest = letterToCol(opposingMoves[i][2]);
-        rDest = letterToRow(opposingMoves[i][3]);
-
-        if(gamePtr->board[rDest][cDest] == playersKing) {
-            freeStringArray(opposingMoves, numOpposingMoves);
-            return TRUE;
-        }    
-    }
-
-    freeStringArray(opposingMoves, numOpposingMoves);
-    return FALSE;
-}
-
-
-/*
- * recieves a move, checks if that move puts the king in check.
- */
-int putsKingInCheck(GameState *gamePtr, char *move, int color) {
-    char overwrittenPiece;
-    overwrittenPiece = tempExecuteMove(gamePtr, move, color);  
-
-    int kingGotChecked = isKingInCheck(gamePtr, color);
-    
-    reverseMove(gamePtr, move, color, overwrittenPiece);
-
-    return kingGotChecked;
-}
-
-/*
- * gets all the moves that are legal for a given
- * color
- */
-int getAllLegalMoves(GameState *gamePtr, char **moveArr, int color) {
-    char **possibleMoveArr = malloc(150 * sizeof(char *));
-    int numPossibleMoves = getAllMoves(gamePtr, possibleMoveArr, color);
-
-    int numLegalMoves = 0;
-    for(int i = 0; i < numPossibleMoves; i++) {
-        if(!putsKingInCheck(gamePtr, possibleMoveArr[i], color)) {
-            moveArr[numLegalMoves++] = possibleMoveArr[i];
-            possibleMoveArr[i] = NULL;
-        }
-    }
-
-
-    freeStringArray(possibleMoveArr, numPossibleMoves);
-
-    return numLegalMoves;
-}
-
-/*
- * gets all moves that are legal for a given piece
- */
-int getPieceLegalMoves(GameState *gamePtr, char **moveArr, int row, int col) {
-    int numMoves = 0;
-    int numLegalMoves = 0;
-    getPieceMoves(gamePtr, moveArr, &numMoves, row, col);
-    int color = pieceIsWhite(gamePtr->board[row][col]);
-
-    for(int i = 0; i < numMoves; i++) {
-        if(!putsKingInCheck(gamePtr, moveArr[i], color)) {
-            moveArr[numLegalMoves++] = moveArr[i];
-        }    
-    }
-
-    return numLegalMoves;
-}
+#include "core.h"
+
+/* the end rows, where pawns promote */
+#define PROMOTION_ROWS 0xFF000000000000FFULL
+
+/* the a and h columns, which pawns cannot capture off the side of */
+#define COL_A 0x0101010101010101ULL
+#define COL_H 0x8080808080808080ULL
+
+/*
+ * adds a move from source to every square in targets to moveList.
+ */
+void addMoves(MoveList *moveList, int source, Bitboard targets) {
+    while(targets) {
+        int dest = popLowestSquare(&targets);
+        moveList->moves[moveList->count++] = MOVE(source, dest, NORMAL_FLAG);
+    }
+}
+
+/*
+ * adds the pawn move from source to dest to moveList.
+ * a move onto an end row is added once per promotion piece.
+ */
+void addPawnMove(MoveList *moveList, int source, int dest) {
+    int destRow = SQUARE_ROW(dest);
+
+    if(destRow == 0 || destRow == 7) {
+        for(int type = QUEEN; type >= KNIGHT; type--) {
+            moveList->moves[moveList->count++] = 
+                PROMOTION_MOVE(source, dest, type);
+        }
+    } else {
+        moveList->moves[moveList->count++] = MOVE(source, dest, NORMAL_FLAG);
+    }
+}
+
+/*
+ * adds a pawn move from source to every square in targets to moveList.
+ */
+void addPawnMoves(MoveList *moveList, int source, Bitboard targets) {
+    while(targets) {
+        addPawnMove(moveList, source, popLowestSquare(&targets));
+    }
+}
+
+/*
+ * adds a pawn move onto every square in dests to moveList,
+ * each from the square sourceOffset away from its dest
+ * (for moves of many pawns at once, E.G. every capture to the left).
+ */
+void addShiftedPawnMoves(MoveList *moveList, Bitboard dests, int sourceOffset) {
+    while(dests) {
+        int dest = popLowestSquare(&dests);
+        addPawnMove(moveList, dest + sourceOffset, dest);
+    }
+}
+
+/*
+ * finds the squares that the pawn of color on square can move to:
+ * single and double jumps onto empty squares, and diagonal captures.
+ */
+Bitboard pawnTargets(GameState *gamePtr, int square, int color) {
+    Bitboard empty = ~gamePtr->occupied;
+    Bitboard bit = SQUARE_BIT(square);
+    Bitboard targets;
+
+    if(color == WHITE) {
+        targets = (bit >> 8) & empty;
+        if(SQUARE_ROW(square) == 6) /* double jump */
+            targets |= (targets >> 8) & empty;
+    } else {
+        targets = (bit << 8) & empty;
+        if(SQUARE_ROW(square) == 1) /* double jump */
+            targets |= (targets << 8) & empty;
+    }
+
+    /* diagonal captures */
+    targets |= pawnAttacks(square, color) & gamePtr->colorBoards[!color];
+
+    return targets;
+}
+
+/*
+ * gets all moves allowed (disregaurding checks) for the piece on square,
+ * according to the state of the board.
+ * only moves onto allowedTargets are added.
+ */
+void getPieceMoves(GameState *gamePtr, MoveList *moveList, int square, 
+                   Bitboard allowedTargets) {
+    char piece = gamePtr->board[SQUARE_ROW(square)][SQUARE_COL(square)];
+    int color = pieceIsWhite(piece);
+    Bitboard occupied = gamePtr->occupied;
+    Bitboard targets;
+
+    /* squares the piece could reach, ignoring friendly collisions */
+    switch(pieceType(piece)) {
+        case PAWN:
+            addPawnMoves(moveList, square, 
+                         pawnTargets(gamePtr, square, color) & allowedTargets);
+            return;
+        case KNIGHT:
+            targets = knightAttacks(square);
+            break;
+        case BISHOP:
+            targets = bishopAttacks(square, occupied);
+            break;
+        case ROOK:
+            targets = rookAttacks(square, occupied);
+            break;
+        case QUEEN:
+            targets = rookAttacks(square, occupied) | 
+                      bishopAttacks(square, occupied);
+            break;
+        case KING:
+            targets = kingAttacks(square);
+            break;
+        default:
+            return;
+    }
+
+    addMoves(moveList, square, 
+             targets & ~gamePtr->colorBoards[color] & allowedTargets);
+}
+
+/*
+ * adds the en passant captures of color's pawns on the squares in pawns
+ * to moveList (disregaurding checks)
+ */
+void getEnPassants(GameState *gamePtr, MoveList *moveList, int color, 
+                   Bitboard pawns) {
+    int dest = gamePtr->enPassantSquare;
+    if(dest == NO_SQUARE)
+        return;
+
+    /* a pawn of color captures onto dest if an enemy pawn there would attack it */
+    Bitboard capturers = pawnAttacks(dest, !color) & 
+                         gamePtr->pieceBoards[color][PAWN] & pawns;
+    while(capturers) {
+        moveList->moves[moveList->count++] = 
+            MOVE(popLowestSquare(&capturers), dest, EN_PASSANT_FLAG);
+    }
+}
+
+/*
+ * is the castle of respective type and color a piece-legal move?
+ * (the castling right must not have been lost, and the squares
+ * between king and rook must be empty; checks are not considered)
+ */
+int canCastle(GameState *gamePtr, int color, int isKingSide) {
+    int row = (color == WHITE) ? 7 : 0;
+    Bitboard king = gamePtr->pieceBoards[color][KING];
+    Bitboard rooks = gamePtr->pieceBoards[color][ROOK];
+
+    int right = (color == WHITE) ? 
+                (isKingSide ? WHITE_KING_SIDE : WHITE_QUEEN_SIDE) :
+                (isKingSide ? BLACK_KING_SIDE : BLACK_QUEEN_SIDE);
+    if(!(gamePtr->castlingRights & right))
+        return FALSE;
+
+    if(isKingSide) {
+        return (king & SQUARE_BIT(SQUARE(row, 4))) && 
+               (rooks & SQUARE_BIT(SQUARE(row, 7))) &&
+               !(gamePtr->occupied & squaresBetween(SQUARE(row, 4), SQUARE(row, 7)));
+    } else {
+        return (king & SQUARE_BIT(SQUARE(row, 4))) && 
+               (rooks & SQUARE_BIT(SQUARE(row, 0))) &&
+               !(gamePtr->occupied & squaresBetween(SQUARE(row, 4), SQUARE(row, 0)));
+    }
+}
+
+
+/*
+ * checks for castle elegibility, and adds
+ * the castles to moveList accordingly.
+ */
+void getCastles(GameState *gamePtr, MoveList *moveList, int color) {
+    int kingSquare = SQUARE((color == WHITE) ? 7 : 0, 4);
+
+    if(canCastle(gamePtr, color, TRUE)) {
+        moveList->moves[moveList->count++] = 
+            MOVE(kingSquare, kingSquare + 2, CASTLE_FLAG);
+    }
+
+    if(canCastle(gamePtr, color, FALSE)) {
+        moveList->moves[moveList->count++] = 
+            MOVE(kingSquare, kingSquare - 2, CASTLE_FLAG);
+    }
+}
+
+/*
+ * gets all moves that are allowed (disregaurding checks) by a given color,
+ * according to the state of the board
+ */
+int getAllMoves(GameState *gamePtr, MoveList *moveList, int color) {
+    moveList->count = 0;
+
+    Bitboard pieces = gamePtr->colorBoards[color];
+    while(pieces) {
+        int square = popLowestSquare(&pieces);
+        getPieceMoves(gamePtr, moveList, square, ~0ULL);
+    }
+
+    getEnPassants(gamePtr, moveList, color, ~0ULL);
+    getCastles(gamePtr, moveList, color);
+    return moveList->count;
+}
+
+/*
+ * is square attacked by any piece of byColor, if only the squares in
+ * occupied block sliding pieces?
+ * looks outward from square with each piece's attack pattern,
+ * and returns as soon as one reaches a matching piece.
+ */
+int squareIsAttackedThrough(GameState *gamePtr, int square, int byColor, 
+                            Bitboard occupied) {
+    Bitboard *attackerBoards = gamePtr->pieceBoards[byColor];
+
+    /* a pawn of byColor attacks square if a pawn on square would attack it */
+    if(pawnAttacks(square, !byColor) & attackerBoards[PAWN])
+        return TRUE;
+    if(knightAttacks(square) & attackerBoards[KNIGHT])
+        return TRUE;
+    if(kingAttacks(square) & attackerBoards[KING])
+        return TRUE;
+
+    Bitboard diagonalAttackers = attackerBoards[BISHOP] | attackerBoards[QUEEN];
+    if(diagonalAttackers && 
+       (bishopAttacks(square, occupied) & diagonalAttackers))
+        return TRUE;
+
+    Bitboard straightAttackers = attackerBoards[ROOK] | attackerBoards[QUEEN];
+    if(straightAttackers && 
+       (rookAttacks(square, occupied) & straightAttackers))
+        return TRUE;
+
+    return FALSE;
+}
+
+/*
+ * is square attacked by any piece of byColor?
+ */
+int squareIsAttacked(GameState *gamePtr, int square, int byColor) {
+    return squareIsAttackedThrough(gamePtr, square, byColor, gamePtr->occupied);
+}
+
+/*
+ * every piece of byColor that attacks square
+ */
+Bitboard attackersOf(GameState *gamePtr, int square, int byColor) {
+    Bitboard *attackerBoards = gamePtr->pieceBoards[byColor];
+    Bitboard occupied = gamePtr->occupied;
+
+    return (pawnAttacks(square, !byColor) & attackerBoards[PAWN]) |
+           (knightAttacks(square) & attackerBoards[KNIGHT]) |
+           (kingAttacks(square) & attackerBoards[KING]) |
+           (bishopAttacks(square, occupied) & 
+            (attackerBoards[BISHOP] | attackerBoards[QUEEN])) |
+           (rookAttacks(square, occupied) & 
+            (attackerBoards[ROOK] | attackerBoards[QUEEN]));
+}
+
+/*
+ * is the king in check?
+ */
+int isKingInCheck(GameState *gamePtr, int color) {
+    Bitboard playersKing = gamePtr->pieceBoards[color][KING];
+    if(!playersKing)
+        return FALSE;
+
+    return squareIsAttacked(gamePtr, __builtin_ctzll(playersKing), !color);
+}
+
+
+/*
+ * recieves a move, checks if that move puts the king in check.
+ */
+int putsKingInCheck(GameState *gamePtr, Move move, int color) {
+    UndoInfo undo;
+    makeMove(gamePtr, move, &undo);  
+
+    int kingGotChecked = isKingInCheck(gamePtr, color);
+    
+    unmakeMove(gamePtr, move, &undo);
+
+    return kingGotChecked;
+}
+
+/*
+ * fills in the checks and pins against color's king,
+ * so moves can be generated legal without trying them on the board.
+ */
+void findCheckInfo(GameState *gamePtr, int color, CheckInfo *infoPtr) {
+    Bitboard *enemyBoards = gamePtr->pieceBoards[!color];
+    int kingSquare = __builtin_ctzll(gamePtr->pieceBoards[color][KING]);
+
+    infoPtr->kingSquare = kingSquare;
+    infoPtr->checkers = attackersOf(gamePtr, kingSquare, !color);
+
+    /* with one checker, other pieces must capture it or block it */
+    if(infoPtr->checkers == 0) {
+        infoPtr->evasionTargets = ~0ULL;
+    } else if((infoPtr->checkers & (infoPtr->checkers - 1)) == 0) {
+        int checkerSquare = __builtin_ctzll(infoPtr->checkers);
+        infoPtr->evasionTargets = infoPtr->checkers | 
+                                  squaresBetween(kingSquare, checkerSquare);
+    } else { /* double check: only the king can move */
+        infoPtr->evasionTargets = 0;
+    }
+
+    /* 
+     * snipers: enemy sliders that would attack the king if
+     * color's pieces were not in the way
+     */
+    Bitboard enemyPieces = gamePtr->colorBoards[!color];
+    Bitboard snipers = 
+        (rookAttacks(kingSquare, enemyPieces) & 
+         (enemyBoards[ROOK] | enemyBoards[QUEEN])) |
+        (bishopAttacks(kingSquare, enemyPieces) & 
+         (enemyBoards[BISHOP] | enemyBoards[QUEEN]));
+
+    infoPtr->pinned = 0;
+    while(snipers) {
+        int sniperSquare = popLowestSquare(&snipers);
+        Bitboard blockers = squaresBetween(kingSquare, sniperSquare) & 
+                            gamePtr->occupied;
+
+        /* exactly one blocker, and it is color's */
+        if(blockers && (blockers & (blockers - 1)) == 0 && 
+           (blockers & gamePtr->colorBoards[color])) {
+            infoPtr->pinned |= blockers;
+        }
+    }
+}
+
+/*
+ * the squares that color's moves of kind (ALL_MOVES, CAPTURE_MOVES or
+ * QUIET_MOVES) may land on. a pawn reaching an end row promotes,
+ * so for pawns those squares count as captures.
+ */
+Bitboard kindTargets(GameState *gamePtr, int color, int kind, int forPawns) {
+    Bitboard captureTargets = gamePtr->colorBoards[!color];
+    if(forPawns)
+        captureTargets |= PROMOTION_ROWS;
+
+    switch(kind) {
+        case CAPTURE_MOVES:
+            return captureTargets;
+        case QUIET_MOVES:
+            return ~captureTargets;
+    }
+    return ~0ULL;
+}
+
+/*
+ * adds the legal moves of color's king (other than castles) onto
+ * allowedTargets to moveList.
+ * each destination is checked with the king lifted off the board,
+ * so it cannot hide from a slider behind its own square.
+ */
+void getKingLegalMoves(GameState *gamePtr, MoveList *moveList, int color, 
+                       CheckInfo *infoPtr, Bitboard allowedTargets) {
+    int kingSquare = infoPtr->kingSquare;
+    Bitboard occupied = gamePtr->occupied & ~SQUARE_BIT(kingSquare);
+    Bitboard targets = kingAttacks(kingSquare) & ~gamePtr->colorBoards[color] & 
+                       allowedTargets;
+
+    while(targets) {
+        int dest = popLowestSquare(&targets);
+        if(!squareIsAttackedThrough(gamePtr, dest, !color, occupied)) {
+            moveList->moves[moveList->count++] = MOVE(kingSquare, dest, 
+                                                      NORMAL_FLAG);
+        }
+    }
+}
+
+/*
+ * adds the legal castles of color to moveList:
+ * the king may not castle out of check, or through or into an attacked square.
+ */
+void getLegalCastles(GameState *gamePtr, MoveList *moveList, int color, 
+                     CheckInfo *infoPtr) {
+    if(infoPtr->checkers)
+        return;
+
+    int firstCastle = moveList->count;
+    getCastles(gamePtr, moveList, color);
+
+    int numLegalMoves = firstCastle;
+    for(int i = firstCastle; i < moveList->count; i++) {
+        int dest = MOVE_DEST(moveList->moves[i]);
+        int passedSquare = (infoPtr->kingSquare + dest) / 2;
+
+        if(!squareIsAttacked(gamePtr, passedSquare, !color) && 
+           !squareIsAttacked(gamePtr, dest, !color)) {
+            moveList->moves[numLegalMoves++] = moveList->moves[i];
+        }
+    }
+    moveList->count = numLegalMoves;
+}
+
+/*
+ * adds the legal en passant captures of color's pawns on the squares 
+ * in pawns to moveList.
+ * they are rare, and can uncover a check along the row both pawns leave,
+ * so they are verified by trying them on the board.
+ */
+void getLegalEnPassants(GameState *gamePtr, MoveList *moveList, int color, 
+                        Bitboard pawns) {
+    int firstCapture = moveList->count;
+    getEnPassants(gamePtr, moveList, color, pawns);
+
+    int numLegalMoves = firstCapture;
+    for(int i = firstCapture; i < moveList->count; i++) {
+        if(!putsKingInCheck(gamePtr, moveList->moves[i], color)) {
+            moveList->moves[numLegalMoves++] = moveList->moves[i];
+        }
+    }
+    moveList->count = numLegalMoves;
+}
+
+/*
+ * adds the legal moves of the (non-king) piece on square onto
+ * allowedTargets to moveList: its moves are restricted to the check 
+ * evasions, and to its pin line if it is pinned.
+ */
+void getNonKingLegalMoves(GameState *gamePtr, MoveList *moveList, int square, 
+                          CheckInfo *infoPtr, Bitboard allowedTargets) {
+    allowedTargets &= infoPtr->evasionTargets;
+    if(infoPtr->pinned & SQUARE_BIT(square)) {
+        allowedTargets &= lineThrough(infoPtr->kingSquare, square);
+    }
+
+    if(allowedTargets) {
+        getPieceMoves(gamePtr, moveList, square, allowedTargets);
+    }
+}
+
+/*
+ * gets the legal moves of a given kind for color (infoPtr: its
+ * findCheckInfo), so a search can generate captures and promotions
+ * (CAPTURE_MOVES) apart from the rest (QUIET_MOVES), or ALL_MOVES at once
+ */
+int getLegalMovesOfKind(GameState *gamePtr, MoveList *moveList, int color, 
+                        int kind, CheckInfo *infoPtr) {
+    Bitboard pieceTargets = kindTargets(gamePtr, color, kind, FALSE);
+
+    moveList->count = 0;
+    getKingLegalMoves(gamePtr, moveList, color, infoPtr, pieceTargets);
+    if(kind != CAPTURE_MOVES)
+        getLegalCastles(gamePtr, moveList, color, infoPtr);
+
+    if(infoPtr->evasionTargets) {
+        Bitboard pawns = gamePtr->pieceBoards[color][PAWN];
+        Bitboard pawnTargets = kindTargets(gamePtr, color, kind, TRUE);
+        Bitboard pieces = gamePtr->colorBoards[color] & 
+                          ~gamePtr->pieceBoards[color][KING];
+        while(pieces) {
+            int square = popLowestSquare(&pieces);
+            getNonKingLegalMoves(gamePtr, moveList, square, infoPtr, 
+                                 (pawns & SQUARE_BIT(square)) ? pawnTargets : pieceTargets);
+        }
+
+        if(kind != QUIET_MOVES)
+            getLegalEnPassants(gamePtr, moveList, color, ~0ULL);
+    }
+
+    return moveList->count;
+}
+
+/*
+ * gets the legal captures and promotions of color (infoPtr: its
+ * findCheckInfo): the same moves as getLegalMovesOfKind's CAPTURE_MOVES,
+ * but found directly rather than by narrowing every piece's moves.
+ * unpinned pawns move all at once, by shifting their bitboard, and other
+ * unpinned pieces only look at the enemy pieces they attack.
+ */
+int getLegalCaptures(GameState *gamePtr, MoveList *moveList, int color, 
+                     CheckInfo *infoPtr) {
+    Bitboard *pieceBoards = gamePtr->pieceBoards[color];
+    Bitboard enemies = gamePtr->colorBoards[!color];
+
+    moveList->count = 0;
+    getKingLegalMoves(gamePtr, moveList, color, infoPtr, enemies);
+    if(!infoPtr->evasionTargets)
+        return moveList->count;
+
+    /* pinned pieces are rare: they go the long way, along their pin lines */
+    Bitboard pinned = infoPtr->pinned & ~pieceBoards[KING];
+    Bitboard pawnTargets = kindTargets(gamePtr, color, CAPTURE_MOVES, TRUE);
+    Bitboard pieceTargets = kindTargets(gamePtr, color, CAPTURE_MOVES, FALSE);
+    while(pinned) {
+        int square = popLowestSquare(&pinned);
+        getNonKingLegalMoves(gamePtr, moveList, square, infoPtr,
+                             (pieceBoards[PAWN] & SQUARE_BIT(square)) ? pawnTargets : pieceTargets);
+    }
+
+    Bitboard captureTargets = enemies & infoPtr->evasionTargets;
+    Bitboard pushTargets = PROMOTION_ROWS & ~gamePtr->occupied & infoPtr->evasionTargets;
+
+    Bitboard pawns = pieceBoards[PAWN] & ~infoPtr->pinned;
+    if(color == WHITE) {
+        addShiftedPawnMoves(moveList, ((pawns & ~COL_A) >> 9) & captureTargets, 9);
+        addShiftedPawnMoves(moveList, ((pawns & ~COL_H) >> 7) & captureTargets, 7);
+        addShiftedPawnMoves(moveList, (pawns >> 8) & pushTargets, 8);
+    } else {
+        addShiftedPawnMoves(moveList, ((pawns & ~COL_A) << 7) & captureTargets, -7);
+        addShiftedPawnMoves(moveList, ((pawns & ~COL_H) << 9) & captureTargets, -9);
+        addShiftedPawnMoves(moveList, (pawns << 8) & pushTargets, -8);
+    }
+
+    Bitboard occupied = gamePtr->occupied;
+    Bitboard pieces = pieceBoards[KNIGHT] & ~infoPtr->pinned;
+    while(pieces) {
+        int square = popLowestSquare(&pieces);
+        addMoves(moveList, square, knightAttacks(square) & captureTargets);
+    }
+    pieces = (pieceBoards[BISHOP] | pieceBoards[QUEEN]) & ~infoPtr->pinned;
+    while(pieces) {
+        int square = popLowestSquare(&pieces);
+        addMoves(moveList, square, bishopAttacks(square, occupied) & captureTargets);
+    }
+    pieces = (pieceBoards[ROOK] | pieceBoards[QUEEN]) & ~infoPtr->pinned;
+    while(pieces) {
+        int square = popLowestSquare(&pieces);
+        addMoves(moveList, square, rookAttacks(square, occupied) & captureTargets);
+    }
+
+    getLegalEnPassants(gamePtr, moveList, color, ~0ULL);
+    return moveList->count;
+}
+
+/*
+ * gets all the moves that are legal for a given
+ * color
+ */
+int getAllLegalMoves(GameState *gamePtr, MoveList *moveList, int color) {
+    CheckInfo info;
+    findCheckInfo(gamePtr, color, &info);
+
+    return getLegalMovesOfKind(gamePtr, moveList, color, ALL_MOVES, &info);
+}
+
+/*
+ * gets all moves that are legal for a given piece
+ * (including castles, if the piece is a king)
+ */
+int getPieceLegalMoves(GameState *gamePtr, MoveList *moveList, int row, int col) {
+    char piece = gamePtr->board[row][col];
+    int color = pieceIsWhite(piece);
+
+    CheckInfo info;
+    findCheckInfo(gamePtr, color, &info);
+
+    moveList->count = 0;
+    if(pieceType(piece) == KING) {
+        getKingLegalMoves(gamePtr, moveList, color, &info, ~0ULL);
+        getLegalCastles(gamePtr, moveList, color, &info);
+    } else {
+        getNonKingLegalMoves(gamePtr, moveList, SQUARE(row, col), &info, ~0ULL);
+        if(info.evasionTargets)
+            getLegalEnPassants(gamePtr, moveList, color, SQUARE_BIT(SQUARE(row, col)));
+    }
+
+    return moveList->count;
+}
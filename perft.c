@@ -0,0 +1,244 @@
+#include "core.h"
+
+/*
+ * perft:
+ * counts the leaf nodes of the legal move tree of gamePtr,
+ * depth plies deep. the last ply is counted from the length of the
+ * move list, without making the moves.
+ */
+long long perft(GameState *gamePtr, int depth) {
+    if(depth == 0)
+        return 1;
+
+    MoveList moves;
+    int numMoves = getAllLegalMoves(gamePtr, &moves, gamePtr->turn);
+    if(depth == 1)
+        return numMoves;
+
+    long long nodes = 0;
+    for(int i = 0; i < numMoves; i++) {
+        UndoInfo undo;
+        makeMove(gamePtr, moves.moves[i], &undo);
+
+        nodes += perft(gamePtr, depth - 1);
+
+        unmakeMove(gamePtr, moves.moves[i], &undo);
+    }
+
+    return nodes;
+}
+
+/*
+ * perft hashed:
+ * perft, with the node counts of subtrees two or more plies deep
+ * cached in ttPtr, so positions reached by different move orders
+ * are only counted once.
+ */
+long long perftHashed(GameState *gamePtr, int depth, TranspositionTable *ttPtr) {
+    if(depth <= 1)
+        return perft(gamePtr, depth);
+
+    long long nodes;
+    if(probeNodeCount(ttPtr, gamePtr->hash, depth, &nodes))
+        return nodes;
+
+    MoveList moves;
+    int numMoves = getAllLegalMoves(gamePtr, &moves, gamePtr->turn);
+
+    nodes = 0;
+    for(int i = 0; i < numMoves; i++) {
+        UndoInfo undo;
+        makeMove(gamePtr, moves.moves[i], &undo);
+
+        nodes += perftHashed(gamePtr, depth - 1, ttPtr);
+
+        unmakeMove(gamePtr, moves.moves[i], &undo);
+    }
+
+    storeNodeCount(ttPtr, gamePtr->hash, depth, nodes);
+    return nodes;
+}
+
+/*
+ * perft copy make:
+ * perft, making each move on a copy of the position rather than
+ * unmaking it afterwards (perft -bench compares the two)
+ */
+long long perftCopyMake(GameState *gamePtr, int depth) {
+    if(depth == 0)
+        return 1;
+
+    MoveList moves;
+    int numMoves = getAllLegalMoves(gamePtr, &moves, gamePtr->turn);
+    if(depth == 1)
+        return numMoves;
+
+    long long nodes = 0;
+    for(int i = 0; i < numMoves; i++) {
+        GameState child = *gamePtr;
+        makeMove(&child, moves.moves[i], NULL);
+
+        nodes += perftCopyMake(&child, depth - 1);
+    }
+
+    return nodes;
+}
+
+/*
+ * a subtree of a parallel perft: one root move and one reply
+ */
+typedef struct _perftTask {
+    int rootIndex; /* index of the root move in PerftJob.rootMoves */
+    Move reply;
+    long long nodes;
+} PerftTask;
+
+/*
+ * the work shared by the threads of a parallel perft
+ */
+typedef struct _perftJob {
+    GameState *rootPtr;
+    MoveList rootMoves;
+    int depth;
+    TranspositionTable *ttPtr; /* NULL for no hashing */
+
+    PerftTask *tasks;
+    int numTasks;
+    int nextTask; /* the next task to hand out (guarded by lock) */
+    Mutex lock;
+} PerftJob;
+
+/*
+ * perft thread:
+ * takes tasks from the job until there are none left,
+ * counting each one on the thread's own copy of the root position.
+ */
+void perftWorker(void *jobArg) {
+    PerftJob *jobPtr = jobArg;
+    GameState game = *jobPtr->rootPtr;
+
+    while(TRUE) {
+        lockMutex(&jobPtr->lock);
+        int taskIndex = jobPtr->nextTask++;
+        unlockMutex(&jobPtr->lock);
+
+        if(taskIndex >= jobPtr->numTasks)
+            return;
+
+        PerftTask *taskPtr = &jobPtr->tasks[taskIndex];
+        Move rootMove = jobPtr->rootMoves.moves[taskPtr->rootIndex];
+        UndoInfo rootUndo, replyUndo;
+
+        makeMove(&game, rootMove, &rootUndo);
+        makeMove(&game, taskPtr->reply, &replyUndo);
+
+        taskPtr->nodes = jobPtr->ttPtr ? 
+                         perftHashed(&game, jobPtr->depth - 2, jobPtr->ttPtr) : 
+                         perft(&game, jobPtr->depth - 2);
+
+        unmakeMove(&game, taskPtr->reply, &replyUndo);
+        unmakeMove(&game, rootMove, &rootUndo);
+    }
+}
+
+/*
+ * perft parallel:
+ * perft, split across numThreads threads. the tree is cut into one task
+ * per (root move, reply) pair, and each thread keeps taking the next
+ * unclaimed task, so threads that draw small subtrees take more of them.
+ * ttPtr may be NULL, to count without a transposition table
+ * (a shared table is safe, see tt.c).
+ *
+ * rootNodes, if not NULL, receives the node count below each root move,
+ * in the order getAllLegalMoves returns them.
+ */
+long long perftParallel(GameState *gamePtr, int depth, TranspositionTable *ttPtr, 
+                        int numThreads, long long *rootNodes) {
+    if(depth == 0)
+        return 1;
+
+    PerftJob job;
+    job.rootPtr = gamePtr;
+    job.depth = depth;
+    job.ttPtr = ttPtr;
+    int numRootMoves = getAllLegalMoves(gamePtr, &job.rootMoves, gamePtr->turn);
+
+    if(depth == 1) {
+        for(int i = 0; rootNodes && i < numRootMoves; i++)
+            rootNodes[i] = 1;
+        return numRootMoves;
+    }
+
+    /* one task per reply to each root move */
+    job.tasks = malloc(numRootMoves * MAX_MOVES * sizeof(PerftTask));
+    job.numTasks = 0;
+    job.nextTask = 0;
+
+    int color = gamePtr->turn;
+    for(int i = 0; i < numRootMoves; i++) {
+        UndoInfo undo;
+        MoveList replies;
+        makeMove(gamePtr, job.rootMoves.moves[i], &undo);
+        getAllLegalMoves(gamePtr, &replies, !color);
+        unmakeMove(gamePtr, job.rootMoves.moves[i], &undo);
+
+        for(int j = 0; j < replies.count; j++) {
+            job.tasks[job.numTasks].rootIndex = i;
+            job.tasks[job.numTasks].reply = replies.moves[j];
+            job.numTasks++;
+        }
+    }
+
+    /* count the tasks (the calling thread counts too) */
+    initMutex(&job.lock);
+
+    Thread *threads = malloc(numThreads * sizeof(Thread));
+    int numStarted = 0;
+    while(numStarted < numThreads - 1 && 
+          startThread(&threads[numStarted], perftWorker, &job)) {
+        numStarted++;
+    }
+    perftWorker(&job);
+    for(int i = 0; i < numStarted; i++) {
+        joinThread(threads[i]);
+    }
+
+    destroyMutex(&job.lock);
+    free(threads);
+
+    /* add up the tasks */
+    long long nodes = 0;
+    for(int i = 0; rootNodes && i < numRootMoves; i++)
+        rootNodes[i] = 0;
+    for(int i = 0; i < job.numTasks; i++) {
+        nodes += job.tasks[i].nodes;
+        if(rootNodes)
+            rootNodes[job.tasks[i].rootIndex] += job.tasks[i].nodes;
+    }
+
+    free(job.tasks);
+    return nodes;
+}
+
+/*
+ * perft divide:
+ * runs perft below each legal move of gamePtr, printing
+ * each move's node count (E.G. "e2e4: 20"). returns the total.
+ * ttPtr may be NULL, to count without a transposition table.
+ */
+long long perftDivide(GameState *gamePtr, int depth, TranspositionTable *ttPtr, 
+                      int numThreads) {
+    MoveList moves;
+    int numMoves = getAllLegalMoves(gamePtr, &moves, gamePtr->turn);
+
+    long long rootNodes[MAX_MOVES];
+    long long nodes = perftParallel(gamePtr, depth, ttPtr, numThreads, rootNodes);
+
+    for(int i = 0; i < numMoves; i++) {
+        char moveStr[6];
+        moveToString(moves.moves[i], moveStr);
+        printf("%s: %lld\n", moveStr, rootNodes[i]);
+    }
+
+    return nodes;
+}
@@ -0,0 +1,190 @@
+#include "core.h"
+
+#define MAX_SUITE_DEPTH 6
+
+/*
+ * a perft test position, and its known node counts
+ * (expectedNodes[d - 1] for depth d, 0 past the last known depth)
+ */
+typedef struct _perftPosition {
+    char *name;
+    char *fen;
+    long long expectedNodes[MAX_SUITE_DEPTH];
+} PerftPosition;
+
+/* the standard perft positions (chessprogramming.org/Perft_Results) */
+PerftPosition perftSuite[] = {
+    {"start", STARTING_FEN,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690, 0}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292, 0}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551, 0}},
+};
+
+#define SUITE_SIZE (sizeof(perftSuite) / sizeof(perftSuite[0]))
+
+/*
+ * prints the node count, time and nodes/second of a perft run
+ */
+void printPerftStats(long long nodes, double startSeconds) {
+    double seconds = wallClockSeconds() - startSeconds;
+
+    printf("nodes: %lld  time: %.3fs", nodes, seconds);
+    if(seconds > 0)
+        printf("  nps: %.0f", nodes / seconds);
+    printf("\n");
+}
+
+/*
+ * runs every suite position up to maxDepth (or its last known count),
+ * comparing against the expected node counts.
+ * ttPtr may be NULL, to count without a transposition table.
+ * returns the number of mismatches.
+ */
+int runSuite(int maxDepth, TranspositionTable *ttPtr, int numThreads) {
+    GameState game;
+    long long totalNodes = 0;
+    int failures = 0;
+    double startSeconds = wallClockSeconds();
+
+    for(int i = 0; i < SUITE_SIZE; i++) {
+        if(!loadFen(&game, perftSuite[i].fen)) {
+            printf("%-12s invalid fen\n", perftSuite[i].name);
+            failures++;
+            continue;
+        }
+
+        for(int depth = 1; depth <= maxDepth; depth++) {
+            long long expected = perftSuite[i].expectedNodes[depth - 1];
+            if(expected == 0)
+                break;
+
+            long long nodes = perftParallel(&game, depth, ttPtr, numThreads, NULL);
+            totalNodes += nodes;
+
+            printf("%-12s depth %d: %12lld  %s", perftSuite[i].name, depth, 
+                   nodes, nodes == expected ? "ok" : "FAIL");
+            if(nodes != expected) {
+                printf(" (expected %lld)", expected);
+                failures++;
+            }
+            printf("\n");
+        }
+    }
+
+    printf("\n%d failure(s)\n", failures);
+    printPerftStats(totalNodes, startSeconds);
+    return failures;
+}
+
+/*
+ * counts every suite position to depth (or its last known count) twice:
+ * with make/unmake, then with copy-make, and prints the speed of each
+ */
+void runBenchmark(int depth) {
+    GameState game;
+
+    for(int copyMake = FALSE; copyMake <= TRUE; copyMake++) {
+        long long totalNodes = 0;
+        double startSeconds = wallClockSeconds();
+
+        for(int i = 0; i < SUITE_SIZE; i++) {
+            int positionDepth = depth;
+            while(perftSuite[i].expectedNodes[positionDepth - 1] == 0)
+                positionDepth--;
+
+            loadFen(&game, perftSuite[i].fen);
+            totalNodes += copyMake ? perftCopyMake(&game, positionDepth) :
+                                     perft(&game, positionDepth);
+        }
+
+        if(copyMake) {
+            printf("copy-make (%d byte GameState)\n    ", (int) sizeof(GameState));
+        } else {
+            printf("make/unmake\n    ");
+        }
+        printPerftStats(totalNodes, startSeconds);
+    }
+}
+
+/*
+ * usage:
+ *     perft [options] <depth> [fen]    divide by root move (default: starting position)
+ *     perft [options] -suite [depth]   check the standard positions (default depth 4)
+ *     perft -bench [depth]             time make/unmake against copy-make (default depth 4)
+ * options:
+ *     -hash <MB>      cache subtree node counts in a transposition table of MB megabytes
+ *     -threads <n>    count on n threads
+ */
+int main(int argc, char **argv) {
+    initEvalTables();
+
+    TranspositionTable tt;
+    TranspositionTable *ttPtr = NULL;
+    int numThreads = 1;
+
+    int argIndex = 1;
+    while(argIndex + 1 < argc) {
+        if(strcmp(argv[argIndex], "-hash") == 0) {
+            if(!initTranspositionTable(&tt, atoi(argv[argIndex + 1]))) {
+                printf("could not allocate %s MB of hash\n", argv[argIndex + 1]);
+                return 1;
+            }
+            ttPtr = &tt;
+        } else if(strcmp(argv[argIndex], "-threads") == 0) {
+            numThreads = atoi(argv[argIndex + 1]);
+            if(numThreads < 1)
+                numThreads = 1;
+        } else {
+            break;
+        }
+        argIndex += 2;
+    }
+
+    if(argIndex < argc && strcmp(argv[argIndex], "-suite") == 0) {
+        int maxDepth = (argIndex + 1 < argc) ? atoi(argv[argIndex + 1]) : 4;
+        if(maxDepth > MAX_SUITE_DEPTH)
+            maxDepth = MAX_SUITE_DEPTH;
+
+        return runSuite(maxDepth, ttPtr, numThreads) == 0 ? 0 : 1;
+    }
+
+    if(argIndex < argc && strcmp(argv[argIndex], "-bench") == 0) {
+        int depth = (argIndex + 1 < argc) ? atoi(argv[argIndex + 1]) : 4;
+        if(depth < 1 || depth > MAX_SUITE_DEPTH)
+            depth = 4;
+
+        runBenchmark(depth);
+        return 0;
+    }
+
+    if(argIndex >= argc || atoi(argv[argIndex]) < 1) {
+        printf("usage: perft [-hash MB] [-threads n] <depth> [fen]\n");
+        printf("       perft [-hash MB] [-threads n] -suite [depth]\n");
+        printf("       perft -bench [depth]\n");
+        return 1;
+    }
+
+    int depth = atoi(argv[argIndex]);
+    char *fen = (argIndex + 1 < argc) ? argv[argIndex + 1] : STARTING_FEN;
+
+    GameState game;
+    if(!loadFen(&game, fen)) {
+        printf("invalid fen: %s\n", fen);
+        return 1;
+    }
+
+    double startSeconds = wallClockSeconds();
+    long long nodes = perftDivide(&game, depth, ttPtr, numThreads);
+
+    printf("\n");
+    printPerftStats(nodes, startSeconds);
+    return 0;
+}
@@ -0,0 +1,470 @@
+#include "core.h"
+
+#define MAX_TAG_LENGTH 256 /* longest tag value kept (longer ones are cut) */
+#define MAX_REPORT_LENGTH 512 /* the report for one game */
+
+/* game results, as PGN writes them */
+#define WHITE_WINS "1-0"
+#define BLACK_WINS "0-1"
+#define DRAW "1/2-1/2"
+#define UNKNOWN_RESULT "*"
+
+/*
+ * shared by every worker: what to print, and the totals so far
+ */
+typedef struct _pgnContext {
+    int printAll; /* report valid games too ? */
+    ArchiveWriter *archivePtr; /* where valid games are packed, or NULL */
+
+    Mutex mutex; /* guards the totals */
+    long long numGames;
+    long long numInvalid;
+} PgnContext;
+
+/*
+ * the tags of a game that replaying it depends on
+ */
+typedef struct _pgnTags {
+    char fen[MAX_TAG_LENGTH]; /* "" for the standard starting position */
+    char result[MAX_TAG_LENGTH];
+} PgnTags;
+
+/*
+ * a replayed game, in the form it is packed into an archive
+ */
+typedef struct _pgnGame {
+    PackedPosition start;
+    Move *moves; /* room for MAX_ARCHIVE_MOVES */
+    int numMoves;
+    int result; /* a GAME_RESULT value */
+} PgnGame;
+
+/*
+ * the start of the line after p (or end)
+ */
+const char *nextLine(const char *p, const char *end) {
+    const char *newline = memchr(p, '\n', end - p);
+    return (newline != NULL) ? newline + 1 : end;
+}
+
+/*
+ * is the line from p to its newline (or end) only whitespace ?
+ */
+int lineIsBlank(const char *p, const char *end) {
+    for(; p < end && *p != '\n'; p++) {
+        if(!isspace((unsigned char) *p))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * the end of the last whole game in data (0 if there is none):
+ * the start of the last tag line that follows something other than
+ * a tag line (the movetext of the game before it)
+ */
+long long lastGameEnd(const char *data, long long length) {
+    for(long long i = length - 1; i > 0; i--) {
+        if(data[i] != '[' || data[i - 1] != '\n')
+            continue;
+
+        /* look back past blank lines for the line before the tag */
+        long long lineEnd = i - 1; /* its '\n' */
+        while(lineEnd > 0) {
+            long long lineStart = lineEnd;
+            while(lineStart > 0 && data[lineStart - 1] != '\n')
+                lineStart--;
+
+            if(!lineIsBlank(data + lineStart, data + lineEnd)) {
+                if(data[lineStart] != '[')
+                    return i;
+                break;
+            }
+            lineEnd = lineStart - 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * reads the tag pair on the line at p (E.G. [Result "1-0"])
+ * into tagsPtr, if it is one that matters
+ */
+void parseTag(const char *p, const char *end, PgnTags *tagsPtr) {
+    const char *lineEnd = nextLine(p, end);
+
+    p++; /* '[' */
+    const char *name = p;
+    while(p < lineEnd && !isspace((unsigned char) *p))
+        p++;
+    int nameLength = p - name;
+
+    char *value;
+    if(nameLength == 3 && strncmp(name, "FEN", 3) == 0) {
+        value = tagsPtr->fen;
+    } else if(nameLength == 6 && strncmp(name, "Result", 6) == 0) {
+        value = tagsPtr->result;
+    } else {
+        return;
+    }
+
+    while(p < lineEnd && *p != '"')
+        p++;
+    p++;
+
+    int length = 0;
+    for(; p < lineEnd && *p != '"' && length < MAX_TAG_LENGTH - 1; p++) {
+        if(*p == '\\' && p + 1 < lineEnd)
+            p++; /* escaped quote or backslash */
+        value[length++] = *p;
+    }
+    value[length] = '\0';
+}
+
+/*
+ * the end of the movetext token at p
+ */
+const char *tokenEnd(const char *p, const char *end) {
+    while(p < end && !isspace((unsigned char) *p) && !strchr("{}();[]$", *p))
+        p++;
+    return p;
+}
+
+/*
+ * skips a comment, variation or other non-move element of the movetext
+ * at p, returning the end of it
+ * (or p, if a move, move number or result is there)
+ */
+const char *skipAnnotation(const char *p, const char *end) {
+    if(*p == '{') {
+        const char *close = memchr(p, '}', end - p);
+        return (close != NULL) ? close + 1 : end;
+    }
+    if(*p == ';' || *p == '%') {
+        return nextLine(p, end);
+    }
+    if(*p == '$') {
+        for(p++; p < end && isdigit((unsigned char) *p); p++)
+            ;
+        return p;
+    }
+    if(*p == '(') {
+        int depth = 0;
+        for(; p < end; p++) {
+            if(*p == '{') {
+                p = skipAnnotation(p, end) - 1;
+            } else if(*p == '(') {
+                depth++;
+            } else if(*p == ')' && --depth == 0) {
+                return p + 1;
+            }
+        }
+        return end;
+    }
+    if(*p == ')' || *p == '}') {
+        return p + 1; /* unbalanced */
+    }
+    return p;
+}
+
+/*
+ * the result a finished game must have, or NULL if any will do
+ */
+const char *requiredResult(int status) {
+    switch(status) {
+        case WHITE_CHECKMATE:
+            return WHITE_WINS;
+        case BLACK_CHECKMATE:
+            return BLACK_WINS;
+        case STALEMATE:
+            return DRAW;
+    }
+    return NULL;
+}
+
+/*
+ * the GAME_RESULT value for a PGN result
+ */
+int gameResultCode(const char *result) {
+    if(strcmp(result, WHITE_WINS) == 0)
+        return GAME_RESULT_WHITE_WINS;
+    if(strcmp(result, BLACK_WINS) == 0)
+        return GAME_RESULT_BLACK_WINS;
+    if(strcmp(result, DRAW) == 0)
+        return GAME_RESULT_DRAW;
+    return GAME_RESULT_UNKNOWN;
+}
+
+/*
+ * replays the game whose movetext starts at p (after its tags) into
+ * *pgnGamePtr, writing a report into report if it is invalid 
+ * (or printAll is on). *endPtr is set to the end of the game.
+ *
+ * returns:
+ * TRUE if the game is valid
+ */
+int replayGame(PgnContext *contextPtr, PgnTags *tagsPtr, const char *p,
+               const char *end, long long offset, const char **endPtr,
+               PgnGame *pgnGamePtr, char *report) {
+    GameState game;
+    int valid = TRUE;
+    int numPlies = 0;
+    char terminator[8] = "";
+
+    report[0] = '\0';
+    if(!loadFen(&game, tagsPtr->fen[0] != '\0' ? tagsPtr->fen : STARTING_FEN)) {
+        sprintf(report, "game at byte %lld: invalid FEN tag \"%s\"\n", offset,
+                tagsPtr->fen);
+        valid = FALSE;
+    } else if(!packPosition(&game, &pgnGamePtr->start)) {
+        sprintf(report, "game at byte %lld: too many pieces to pack in FEN tag \"%s\"\n",
+                offset, tagsPtr->fen);
+        valid = FALSE;
+    }
+
+    while(p < end) {
+        if(isspace((unsigned char) *p)) {
+            p++;
+            continue;
+        }
+
+        /* a tag line: the game has ended with no result */
+        if(*p == '[' && p[-1] == '\n')
+            break;
+
+        const char *skipped = skipAnnotation(p, end);
+        if(skipped != p) {
+            p = skipped;
+            continue;
+        }
+
+        const char *token = p;
+        p = tokenEnd(p, end);
+        int length = p - token;
+        if(length == 0) {
+            p++; /* a stray '[' or ']' */
+            continue;
+        }
+
+        /* results end the game */
+        if((length == 3 && (strncmp(token, WHITE_WINS, 3) == 0 ||
+                            strncmp(token, BLACK_WINS, 3) == 0)) ||
+           (length == 7 && strncmp(token, DRAW, 7) == 0) ||
+           (length == 1 && *token == '*')) {
+            memcpy(terminator, token, length);
+            terminator[length] = '\0';
+            break;
+        }
+
+        /* move numbers (E.G. 12. or 12...), possibly stuck to the move */
+        int isCastle = length > 1 && strncmp(token, "0-", 2) == 0;
+        if(isdigit((unsigned char) *token) && !isCastle) {
+            while(token < p && isdigit((unsigned char) *token))
+                token++;
+            while(token < p && *token == '.')
+                token++;
+            length = p - token;
+            if(length == 0)
+                continue;
+        }
+
+        if(!valid)
+            continue; /* already reported: just find the end of the game */
+
+        Move move = parseSan(&game, token, length);
+        if(move == NO_MOVE) {
+            sprintf(report, "game at byte %lld: illegal move %d%s %.*s (ply %d)\n",
+                    offset, game.fullmoveNumber,
+                    game.turn == WHITE ? "." : "...",
+                    length > 32 ? 32 : length, token, numPlies + 1);
+            valid = FALSE;
+            continue;
+        }
+
+        makeMove(&game, move, NULL);
+        if(numPlies < MAX_ARCHIVE_MOVES)
+            pgnGamePtr->moves[numPlies] = move;
+        numPlies++;
+    }
+    *endPtr = p;
+
+    if(!valid)
+        return FALSE;
+    if(contextPtr->archivePtr != NULL && numPlies > MAX_ARCHIVE_MOVES) {
+        sprintf(report, "game at byte %lld: too long to pack (%d plies)\n",
+                offset, numPlies);
+        return FALSE;
+    }
+
+    /* the result must agree with itself, and with a mate or stalemate */
+    int status = gameStatus(&game, NULL);
+    const char *result = (terminator[0] != '\0') ? terminator : tagsPtr->result;
+    const char *required = requiredResult(status);
+
+    if(terminator[0] != '\0' && tagsPtr->result[0] != '\0' &&
+       strcmp(terminator, tagsPtr->result) != 0) {
+        sprintf(report, "game at byte %lld: Result tag %s does not match %s\n",
+                offset, tagsPtr->result, terminator);
+        return FALSE;
+    }
+    if(required != NULL && strcmp(result, required) != 0) {
+        sprintf(report, "game at byte %lld: result %s after %s, expected %s\n",
+                offset, result[0] != '\0' ? result : "missing",
+                status == STALEMATE ? "stalemate" : "checkmate", required);
+        return FALSE;
+    }
+
+    pgnGamePtr->numMoves = numPlies;
+    pgnGamePtr->result = gameResultCode(result);
+
+    if(contextPtr->printAll) {
+        char statusNote[32] = "";
+        if(status != CONTINUE)
+            sprintf(statusNote, " (%s)", statusName(status));
+        sprintf(report, "game at byte %lld: ok, %d plies, %s%s\n", offset,
+                numPlies, result[0] != '\0' ? result : UNKNOWN_RESULT, statusNote);
+    }
+    return TRUE;
+}
+
+/*
+ * replays every game in input, appending a report line per
+ * invalid game (or every game, with printAll) to outputPtr.
+ * when packing, the valid games' records go to outputPtr instead,
+ * and the reports straight to stderr.
+ */
+void analyzeGames(void *context, const char *input, long long length,
+                  long long offset, TextBuffer *outputPtr) {
+    PgnContext *contextPtr = context;
+    const char *p = input;
+    const char *end = input + length;
+    char report[MAX_REPORT_LENGTH];
+    long long numGames = 0;
+    long long numInvalid = 0;
+
+    PgnGame pgnGame;
+    pgnGame.moves = malloc(MAX_ARCHIVE_MOVES * sizeof(Move));
+
+    while(p < end) {
+        if(isspace((unsigned char) *p)) {
+            p++;
+            continue;
+        }
+
+        const char *gameStart = p;
+        PgnTags tags;
+        tags.fen[0] = '\0';
+        tags.result[0] = '\0';
+
+        while(p < end && *p == '[') {
+            parseTag(p, end, &tags);
+            p = nextLine(p, end);
+            while(p < end && isspace((unsigned char) *p))
+                p++;
+        }
+
+        numGames++;
+        int valid = replayGame(contextPtr, &tags, p, end, 
+                               offset + (gameStart - input), &p, &pgnGame, report);
+        if(!valid)
+            numInvalid++;
+
+        if(contextPtr->archivePtr == NULL) {
+            appendText(outputPtr, report, strlen(report));
+        } else {
+            fputs(report, stderr);
+            if(valid) {
+                appendGameRecord(outputPtr, &pgnGame.start, pgnGame.moves, 
+                                 pgnGame.numMoves, pgnGame.result);
+            }
+        }
+    }
+
+    free(pgnGame.moves);
+
+    lockMutex(&contextPtr->mutex);
+    contextPtr->numGames += numGames;
+    contextPtr->numInvalid += numInvalid;
+    unlockMutex(&contextPtr->mutex);
+}
+
+/*
+ * writes a chunk's game records to the archive
+ * (the pipeline's write handler, when packing)
+ */
+void writeArchive(void *context, const char *output, long long length) {
+    PgnContext *contextPtr = context;
+    writeGameRecords(contextPtr->archivePtr, output, length);
+}
+
+/*
+ * usage:
+ *     pgn [options] [file]    check the games in a PGN file (default: stdin)
+ * options:
+ *     -threads <n>    replay games on n threads (default: one per processor)
+ *     -all            report every game, not just invalid ones
+ *     -pack <file>    also write the valid games to an archive (see archive.c)
+ */
+int main(int argc, char **argv) {
+    initEvalTables();
+
+    PgnContext context;
+    context.printAll = FALSE;
+    context.archivePtr = NULL;
+    ArchiveWriter archive;
+    context.numGames = 0;
+    context.numInvalid = 0;
+    initMutex(&context.mutex);
+    int numThreads = processorCount();
+
+    int argIndex = 1;
+    while(argIndex < argc) {
+        if(strcmp(argv[argIndex], "-threads") == 0 && argIndex + 1 < argc) {
+            numThreads = atoi(argv[++argIndex]);
+            if(numThreads < 1)
+                numThreads = 1;
+        } else if(strcmp(argv[argIndex], "-all") == 0) {
+            context.printAll = TRUE;
+        } else if(strcmp(argv[argIndex], "-pack") == 0 && argIndex + 1 < argc) {
+            if(!createArchive(&archive, argv[++argIndex])) {
+                printf("could not create %s\n", argv[argIndex]);
+                return 1;
+            }
+            context.archivePtr = &archive;
+        } else {
+            break;
+        }
+        argIndex++;
+    }
+
+    if(argIndex + 1 < argc || (argIndex < argc && argv[argIndex][0] == '-' &&
+                               argv[argIndex][1] != '\0')) {
+        printf("usage: pgn [-threads n] [-all] [-pack archive] [file]\n");
+        return 1;
+    }
+
+    /* "-" (or no file) is stdin */
+    const char *path = (argIndex < argc && strcmp(argv[argIndex], "-") != 0) ?
+                       argv[argIndex] : NULL;
+
+    double startSeconds = wallClockSeconds();
+    PipelineHandlers handlers = {lastGameEnd, analyzeGames, NULL, &context};
+    if(context.archivePtr != NULL)
+        handlers.write = writeArchive;
+    if(!runPipeline(path, &handlers, numThreads)) {
+        fprintf(stderr, "could not read %s\n", path);
+        return 1;
+    }
+    if(context.archivePtr != NULL && !finishArchive(context.archivePtr)) {
+        fprintf(stderr, "could not write the archive\n");
+        return 1;
+    }
+
+    double seconds = wallClockSeconds() - startSeconds;
+    fprintf(stderr, "%lld games, %lld invalid, %.2fs (%.0f games/minute)\n",
+            context.numGames, context.numInvalid, seconds,
+            seconds > 0 ? context.numGames * 60 / seconds : 0);
+
+    destroyMutex(&context.mutex);
+    return context.numInvalid == 0 ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+#include "core.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define CHUNK_SIZE (256 * 1024) /* bytes of input handed to a worker at once */
+#define CHUNKS_PER_THREAD 4 /* chunks in flight, per worker */
+
+/* Chunk.state */
+#define CHUNK_EMPTY 0 /* free to be filled with input */
+#define CHUNK_READY 1 /* waiting for (or being analyzed by) a worker */
+#define CHUNK_DONE 2 /* analyzed, waiting to be written */
+
+/*
+ * a run of whole records of input, and the results for them
+ */
+typedef struct _chunk {
+    const char *input; /* into the mapped file, or into buffer */
+    long long inputLength;
+    long long inputOffset; /* where input starts, in the whole stream */
+    char *buffer; /* stdin only: room for CHUNK_SIZE bytes of input */
+
+    TextBuffer output;
+
+    int state; /* CHUNK_EMPTY, CHUNK_READY or CHUNK_DONE */
+} Chunk;
+
+/*
+ * the pipeline: the main thread reads input into a ring of chunks,
+ * workers analyze them, and the main thread writes them out in order
+ * as they finish, before refilling them.
+ */
+typedef struct _pipeline {
+    PipelineHandlers *handlersPtr;
+
+    Chunk *chunks;
+    int numChunks;
+    long long numQueued; /* chunks made ready so far */
+    long long nextToAnalyze; /* sequence number of the next chunk for a worker */
+    int finished; /* no more chunks will be queued */
+
+    Mutex mutex; /* guards the counters, finished and every Chunk.state */
+    Condition changed; /* broadcast whenever any of those change */
+} Pipeline;
+
+/*
+ * maps the file at path into memory.
+ * returns FALSE if it could not be opened or mapped.
+ */
+int mapFile(MappedFile *filePtr, const char *path) {
+    filePtr->data = NULL;
+    filePtr->length = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return FALSE;
+    }
+    filePtr->length = size.QuadPart;
+
+    if(filePtr->length > 0) {
+        /* the view keeps the file open once the handles are closed */
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping != NULL) {
+            filePtr->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path, O_RDONLY);
+    if(file < 0)
+        return FALSE;
+
+    struct stat info;
+    if(fstat(file, &info) != 0) {
+        close(file);
+        return FALSE;
+    }
+    filePtr->length = info.st_size;
+
+    if(filePtr->length > 0) {
+        void *data = mmap(NULL, filePtr->length, PROT_READ, MAP_PRIVATE, file, 0);
+        if(data != MAP_FAILED) {
+            madvise(data, filePtr->length, MADV_SEQUENTIAL);
+            filePtr->data = data;
+        }
+    }
+    close(file);
+#endif
+
+    return filePtr->length == 0 || filePtr->data != NULL;
+}
+
+void unmapFile(MappedFile *filePtr) {
+    if(filePtr->data == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(filePtr->data);
+#else
+    munmap((void *) filePtr->data, filePtr->length);
+#endif
+}
+
+/*
+ * adds length bytes of text to the end of the buffer
+ */
+void appendText(TextBuffer *bufferPtr, const char *text, int length) {
+    if(bufferPtr->length + length > bufferPtr->capacity) {
+        bufferPtr->capacity = 2 * (bufferPtr->length + length);
+        bufferPtr->text = realloc(bufferPtr->text, bufferPtr->capacity);
+    }
+
+    memcpy(bufferPtr->text + bufferPtr->length, text, length);
+    bufferPtr->length += length;
+}
+
+/*
+ * the end of the last whole line in data (0 if there is none)
+ */
+long long lastLineEnd(const char *data, long long length) {
+    while(length > 0 && data[length - 1] != '\n')
+        length--;
+    return length;
+}
+
+/*
+ * the worker threads: analyze chunks in the order they were queued,
+ * until the input runs out
+ */
+void pipelineWorker(void *arg) {
+    Pipeline *pipelinePtr = arg;
+    PipelineHandlers *handlersPtr = pipelinePtr->handlersPtr;
+
+    lockMutex(&pipelinePtr->mutex);
+    while(TRUE) {
+        while(pipelinePtr->nextToAnalyze == pipelinePtr->numQueued && 
+              !pipelinePtr->finished)
+            waitCondition(&pipelinePtr->changed, &pipelinePtr->mutex);
+        if(pipelinePtr->nextToAnalyze == pipelinePtr->numQueued)
+            break;
+
+        long long sequence = pipelinePtr->nextToAnalyze++;
+        Chunk *chunkPtr = &pipelinePtr->chunks[sequence % pipelinePtr->numChunks];
+        unlockMutex(&pipelinePtr->mutex);
+
+        handlersPtr->analyze(handlersPtr->context, chunkPtr->input, 
+                             chunkPtr->inputLength, chunkPtr->inputOffset, 
+                             &chunkPtr->output);
+
+        lockMutex(&pipelinePtr->mutex);
+        chunkPtr->state = CHUNK_DONE;
+        broadcastCondition(&pipelinePtr->changed);
+    }
+    unlockMutex(&pipelinePtr->mutex);
+}
+
+/*
+ * waits for the chunk's results (if it has been queued), writes them
+ * (to stdout, unless the handlers say otherwise) and empties it
+ */
+void flushChunk(Pipeline *pipelinePtr, Chunk *chunkPtr) {
+    lockMutex(&pipelinePtr->mutex);
+    while(chunkPtr->state == CHUNK_READY)
+        waitCondition(&pipelinePtr->changed, &pipelinePtr->mutex);
+    unlockMutex(&pipelinePtr->mutex);
+
+    if(chunkPtr->state == CHUNK_DONE) {
+        PipelineHandlers *handlersPtr = pipelinePtr->handlersPtr;
+        if(handlersPtr->write != NULL) {
+            handlersPtr->write(handlersPtr->context, chunkPtr->output.text, 
+                               chunkPtr->output.length);
+        } else {
+            fwrite(chunkPtr->output.text, 1, chunkPtr->output.length, stdout);
+            fflush(stdout);
+        }
+    }
+
+    chunkPtr->output.length = 0;
+    chunkPtr->state = CHUNK_EMPTY;
+}
+
+/*
+ * fills the chunk with the next whole records of the mapped file,
+ * pointing into it rather than copying.
+ * *offsetPtr is how far into the file the previous chunks went.
+ */
+void readMappedChunk(Pipeline *pipelinePtr, MappedFile *filePtr, 
+                     long long *offsetPtr, Chunk *chunkPtr) {
+    long long start = *offsetPtr;
+    long long remaining = filePtr->length - start;
+    long long length = remaining;
+
+    /* widen the window until it holds a whole record (or the rest of the file) */
+    for(long long window = CHUNK_SIZE; window < remaining; window *= 2) {
+        length = pipelinePtr->handlersPtr->lastRecordEnd(filePtr->data + start, window);
+        if(length > 0)
+            break;
+        length = remaining;
+    }
+
+    chunkPtr->input = filePtr->data + start;
+    chunkPtr->inputLength = length;
+    chunkPtr->inputOffset = start;
+    *offsetPtr = start + length;
+}
+
+/*
+ * fills the chunk with the next whole records of stdin.
+ * a partial record at the end is left in leftover (which holds
+ * *leftoverLengthPtr bytes) for the next chunk.
+ * *offsetPtr is how far into stdin the previous chunks went.
+ */
+void readStdinChunk(Pipeline *pipelinePtr, char *leftover, int *leftoverLengthPtr, 
+                    long long *offsetPtr, Chunk *chunkPtr) {
+    memcpy(chunkPtr->buffer, leftover, *leftoverLengthPtr);
+    long long length = *leftoverLengthPtr;
+    length += fread(chunkPtr->buffer + length, 1, CHUNK_SIZE - length, stdin);
+
+    /*
+     * hold back the partial record, unless this is the end of the input
+     * (or the record fills the whole chunk, and is cut in two)
+     */
+    long long end = length;
+    if(length == CHUNK_SIZE) {
+        end = pipelinePtr->handlersPtr->lastRecordEnd(chunkPtr->buffer, length);
+        if(end == 0)
+            end = length;
+    }
+
+    *leftoverLengthPtr = length - end;
+    memcpy(leftover, chunkPtr->buffer + end, *leftoverLengthPtr);
+
+    chunkPtr->input = chunkPtr->buffer;
+    chunkPtr->inputLength = end;
+    chunkPtr->inputOffset = *offsetPtr;
+    *offsetPtr += end;
+}
+
+/*
+ * run pipeline:
+ * splits the file at path (or stdin, if path is NULL) into chunks of
+ * whole records, analyzes them on numThreads workers, and writes the
+ * results to stdout in input order. at most a few chunks per worker
+ * are held at once, however large the input.
+ *
+ * returns:
+ * FALSE if the file could not be read
+ */
+int runPipeline(const char *path, PipelineHandlers *handlersPtr, int numThreads) {
+    MappedFile file;
+    if(path != NULL && !mapFile(&file, path))
+        return FALSE;
+
+    Pipeline pipeline;
+    pipeline.handlersPtr = handlersPtr;
+    pipeline.numChunks = numThreads * CHUNKS_PER_THREAD;
+    pipeline.chunks = calloc(pipeline.numChunks, sizeof(Chunk));
+    pipeline.numQueued = 0;
+    pipeline.nextToAnalyze = 0;
+    pipeline.finished = FALSE;
+    initMutex(&pipeline.mutex);
+    initCondition(&pipeline.changed);
+
+    char *leftover = NULL;
+    int leftoverLength = 0;
+    if(path == NULL) {
+        leftover = malloc(CHUNK_SIZE);
+        for(int i = 0; i < pipeline.numChunks; i++)
+            pipeline.chunks[i].buffer = malloc(CHUNK_SIZE);
+    }
+
+    Thread *threads = malloc(numThreads * sizeof(Thread));
+    for(int i = 0; i < numThreads; i++)
+        startThread(&threads[i], pipelineWorker, &pipeline);
+
+    /* read, queue and (once the ring wraps around) write, in order */
+    long long inputOffset = 0;
+    while(TRUE) {
+        Chunk *chunkPtr = &pipeline.chunks[pipeline.numQueued % pipeline.numChunks];
+        flushChunk(&pipeline, chunkPtr);
+
+        if(path != NULL) {
+            readMappedChunk(&pipeline, &file, &inputOffset, chunkPtr);
+        } else {
+            readStdinChunk(&pipeline, leftover, &leftoverLength, &inputOffset, 
+                           chunkPtr);
+        }
+        if(chunkPtr->inputLength == 0)
+            break;
+
+        lockMutex(&pipeline.mutex);
+        chunkPtr->state = CHUNK_READY;
+        pipeline.numQueued++;
+        broadcastCondition(&pipeline.changed);
+        unlockMutex(&pipeline.mutex);
+    }
+
+    lockMutex(&pipeline.mutex);
+    pipeline.finished = TRUE;
+    broadcastCondition(&pipeline.changed);
+    unlockMutex(&pipeline.mutex);
+
+    /* write what is still in flight, oldest first */
+    for(int i = 0; i < pipeline.numChunks; i++) {
+        flushChunk(&pipeline, 
+                   &pipeline.chunks[(pipeline.numQueued + i) % pipeline.numChunks]);
+    }
+
+    for(int i = 0; i < numThreads; i++)
+        joinThread(threads[i]);
+
+    for(int i = 0; i < pipeline.numChunks; i++) {
+        free(pipeline.chunks[i].buffer);
+        free(pipeline.chunks[i].output.text);
+    }
+    free(pipeline.chunks);
+    free(threads);
+    free(leftover);
+    destroyCondition(&pipeline.changed);
+    destroyMutex(&pipeline.mutex);
+    if(path != NULL)
+        unmapFile(&file);
+
+    return TRUE;
+}
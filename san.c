@@ -0,0 +1,114 @@
+#include "core.h"
+
+/*
+ * parse san:
+ * converts a move in Standard Algebraic Notation (E.G. Nf3, exd5, Rad1,
+ * e8=Q+, O-O) into the matching legal Move for the side to move.
+ * san is length chars long (it need not be '\0' terminated).
+ * check, mate and annotation marks (+ # ! ?) are ignored, as are
+ * the '-' of long algebraic moves (E.G. e2-e4) and zeros for castles.
+ * the capture mark must be there exactly when the move captures, and
+ * pawn captures must name the pawn's file (exd5, not d5).
+ *
+ * returns:
+ * the move, or NO_MOVE if san is not a legal, unambiguous move
+ */
+Move parseSan(GameState *gamePtr, const char *san, int length) {
+    while(length > 0 && (san[length - 1] == '+' || san[length - 1] == '#' ||
+                         san[length - 1] == '!' || san[length - 1] == '?'))
+        length--;
+    if(length < 2)
+        return NO_MOVE;
+
+    int castleRow = (gamePtr->turn == WHITE) ? 7 : 0;
+    int isCastle = FALSE;
+    int type = PAWN;
+    int promotionType = NO_PIECE;
+    int dest = NO_SQUARE;
+    int sourceRow = -1; /* -1: any */
+    int sourceCol = -1;
+    int isCapture = FALSE; /* written with an x ? */
+
+    if(san[0] == 'O' || san[0] == '0') {
+        /* castles: O-O or O-O-O */
+        if(length == 3 && san[1] == '-' && san[2] == san[0]) {
+            dest = SQUARE(castleRow, 6);
+        } else if(length == 5 && san[1] == '-' && san[2] == san[0] &&
+                  san[3] == '-' && san[4] == san[0]) {
+            dest = SQUARE(castleRow, 2);
+        } else {
+            return NO_MOVE;
+        }
+        isCastle = TRUE;
+        type = KING;
+    } else {
+        int i = 0;
+        if(san[0] == 'N' || san[0] == 'B' || san[0] == 'R' ||
+           san[0] == 'Q' || san[0] == 'K') {
+            type = pieceType(san[0]);
+            i++;
+        }
+
+        /* promotion piece, E.G. the Q of e8=Q (or e8Q) */
+        if(type == PAWN && length - i > 2 && strchr("NBRQ", san[length - 1])) {
+            promotionType = pieceType(san[length - 1]);
+            length--;
+            if(san[length - 1] == '=')
+                length--;
+        }
+
+        /* destination */
+        if(length - i < 2)
+            return NO_MOVE;
+        char destFile = san[length - 2];
+        char destRank = san[length - 1];
+        if(destFile < 'a' || destFile > 'h' || destRank < '1' || destRank > '8')
+            return NO_MOVE;
+        dest = SQUARE(letterToRow(destRank), letterToCol(destFile));
+
+        /* disambiguation and capture marks in between */
+        for(; i < length - 2; i++) {
+            if(san[i] >= 'a' && san[i] <= 'h') {
+                sourceCol = letterToCol(san[i]);
+            } else if(san[i] >= '1' && san[i] <= '8') {
+                sourceRow = letterToRow(san[i]);
+            } else if(san[i] == 'x') {
+                isCapture = TRUE;
+            } else if(san[i] != '-') {
+                return NO_MOVE;
+            }
+        }
+    }
+
+    MoveList legalMoves;
+    int numMoves = getAllLegalMoves(gamePtr, &legalMoves, gamePtr->turn);
+
+    Move found = NO_MOVE;
+    for(int i = 0; i < numMoves; i++) {
+        Move move = legalMoves.moves[i];
+        int source = MOVE_SOURCE(move);
+
+        if(MOVE_DEST(move) != dest ||
+           (MOVE_FLAGS(move) == CASTLE_FLAG) != isCastle)
+            continue;
+        if(pieceType(gamePtr->board[SQUARE_ROW(source)][SQUARE_COL(source)]) != type)
+            continue;
+        if((sourceRow >= 0 && SQUARE_ROW(source) != sourceRow) ||
+           (sourceCol >= 0 && SQUARE_COL(source) != sourceCol))
+            continue;
+        if(MOVE_IS_PROMOTION(move) ? MOVE_PROMOTION_TYPE(move) != promotionType
+                                   : promotionType != NO_PIECE)
+            continue;
+
+        int captures = gamePtr->board[SQUARE_ROW(dest)][SQUARE_COL(dest)] != ' ' ||
+                       MOVE_FLAGS(move) == EN_PASSANT_FLAG;
+        if(captures != isCapture || (captures && type == PAWN && sourceCol < 0))
+            continue;
+
+        if(found != NO_MOVE)
+            return NO_MOVE; /* ambiguous */
+        found = move;
+    }
+
+    return found;
+}
@@ -0,0 +1,492 @@
+#include "core.h"
+
+/* how many nodes are searched between checks of the time limit */
+#define NODES_PER_TIME_CHECK 1024
+
+#define NUM_KILLERS 2 /* quiet moves remembered per ply */
+
+/* stages of a MovePicker, in the order they are gone through */
+#define PICK_HASH_MOVE 0
+#define GENERATE_CAPTURES 1
+#define PICK_CAPTURES 2
+#define PICK_KILLERS 3
+#define GENERATE_QUIETS 4
+#define PICK_QUIETS 5
+#define PICK_DONE 6
+
+/*
+ * the state of one search, shared by every node
+ */
+typedef struct _searchState {
+    SearchLimits *limitsPtr;
+    double startSeconds;
+    long long nodes;
+    int stopped; /* a limit ran out: results of the current iteration are void */
+    Move rootBestMove; /* best move of the last completed iteration */
+    PositionHistory history; /* the game so far, then the line being searched */
+    TranspositionTable *ttPtr; /* NULL, or where results are kept between nodes */
+    Move killers[MAX_SEARCH_DEPTH][NUM_KILLERS]; /* [ply]: quiet moves that cut off */
+} SearchState;
+
+/*
+ * hands out the legal moves of a position one at a time, likely best first.
+ * each stage is only generated once the ones before it are used up,
+ * and most nodes cut off after a move or two, so the quiet moves
+ * (most of the moves) are often never generated at all:
+ *     the hash move (the best move found here by an earlier search),
+ *     captures and promotions, most valuable victim first (MVV-LVA),
+ *     killers (quiet moves that cut off elsewhere at the same ply),
+ *     the rest of the quiet moves.
+ */
+typedef struct _movePicker {
+    GameState *gamePtr;
+    CheckInfo info; /* of the side to move, for every stage */
+    int stage;
+    Move hashMove;
+    Move killers[NUM_KILLERS];
+    int killerIndex;
+    MoveList moves; /* the captures, then the quiet moves */
+    int scores[MAX_MOVES];
+    int next; /* index of the next of moves to hand out */
+} MovePicker;
+
+/*
+ * did the search run out of time or nodes, or was it told to stop?
+ * the clock is only read every NODES_PER_TIME_CHECK nodes.
+ */
+int searchShouldStop(SearchState *searchPtr) {
+    SearchLimits *limitsPtr = searchPtr->limitsPtr;
+
+    if(limitsPtr->stopPtr && *limitsPtr->stopPtr)
+        return TRUE;
+
+    if(limitsPtr->maxNodes > 0 && searchPtr->nodes >= limitsPtr->maxNodes)
+        return TRUE;
+
+    if(limitsPtr->maxSeconds > 0 && 
+       searchPtr->nodes % NODES_PER_TIME_CHECK == 0 &&
+       wallClockSeconds() - searchPtr->startSeconds >= limitsPtr->maxSeconds)
+        return TRUE;
+
+    return FALSE;
+}
+
+/*
+ * scores each move for ordering: captures first, most valuable victim
+ * first, and among equal victims, least valuable attacker first (MVV-LVA).
+ * promotions come next, then quiet moves.
+ */
+void scoreMoves(GameState *gamePtr, MoveList *moveList, int *scores) {
+    for(int i = 0; i < moveList->count; i++) {
+        Move move = moveList->moves[i];
+        int source = MOVE_SOURCE(move);
+        int dest = MOVE_DEST(move);
+        char victim = gamePtr->board[SQUARE_ROW(dest)][SQUARE_COL(dest)];
+        char attacker = gamePtr->board[SQUARE_ROW(source)][SQUARE_COL(source)];
+        if(MOVE_FLAGS(move) == EN_PASSANT_FLAG)
+            victim = attacker; /* a pawn for a pawn */
+
+        scores[i] = 0;
+        if(victim != ' ')
+            scores[i] = 1000 + 10 * pieceValue(victim) - pieceValue(attacker);
+
+        if(MOVE_IS_PROMOTION(move))
+            scores[i] += 100 * pieceValue(pieceChar(MOVE_PROMOTION_TYPE(move), WHITE));
+    }
+}
+
+/*
+ * moves the highest scoring move from index onward to index
+ * (a selection sort step: most nodes cut off after a few moves,
+ * so the rest of the list is never sorted)
+ */
+void pickNextMove(MoveList *moveList, int *scores, int index) {
+    int best = index;
+    for(int i = index + 1; i < moveList->count; i++) {
+        if(scores[i] > scores[best])
+            best = i;
+    }
+
+    Move move = moveList->moves[index];
+    moveList->moves[index] = moveList->moves[best];
+    moveList->moves[best] = move;
+
+    int score = scores[index];
+    scores[index] = scores[best];
+    scores[best] = score;
+}
+
+/*
+ * is move quiet (not a capture or promotion) in gamePtr?
+ */
+int isQuietMove(GameState *gamePtr, Move move) {
+    int dest = MOVE_DEST(move);
+    return gamePtr->board[SQUARE_ROW(dest)][SQUARE_COL(dest)] == ' ' &&
+           !MOVE_IS_PROMOTION(move) && MOVE_FLAGS(move) != EN_PASSANT_FLAG;
+}
+
+/*
+ * starts picking the moves of gamePtr's side to move
+ * (hashMove and killers may be NO_MOVE, or not even legal here)
+ */
+void initMovePicker(MovePicker *pickerPtr, GameState *gamePtr, Move hashMove, 
+                    Move *killers) {
+    pickerPtr->gamePtr = gamePtr;
+    findCheckInfo(gamePtr, gamePtr->turn, &pickerPtr->info);
+    pickerPtr->stage = PICK_HASH_MOVE;
+    pickerPtr->hashMove = hashMove;
+    for(int i = 0; i < NUM_KILLERS; i++)
+        pickerPtr->killers[i] = killers[i];
+    pickerPtr->killerIndex = 0;
+    pickerPtr->moves.count = 0;
+    pickerPtr->next = 0;
+}
+
+/*
+ * the next move to try, or NO_MOVE once every legal move has been.
+ * a move handed out by an earlier stage is skipped by later ones.
+ */
+Move nextMove(MovePicker *pickerPtr) {
+    GameState *gamePtr = pickerPtr->gamePtr;
+
+    while(TRUE) {
+        switch(pickerPtr->stage) {
+            case PICK_HASH_MOVE:
+                pickerPtr->stage = GENERATE_CAPTURES;
+                if(pickerPtr->hashMove != NO_MOVE && moveIsLegal(gamePtr, pickerPtr->hashMove))
+                    return pickerPtr->hashMove;
+                pickerPtr->hashMove = NO_MOVE;
+                break;
+
+            case GENERATE_CAPTURES:
+                getLegalCaptures(gamePtr, &pickerPtr->moves, gamePtr->turn, 
+                                 &pickerPtr->info);
+                scoreMoves(gamePtr, &pickerPtr->moves, pickerPtr->scores);
+                pickerPtr->next = 0;
+                pickerPtr->stage = PICK_CAPTURES;
+                break;
+
+            case PICK_CAPTURES:
+                while(pickerPtr->next < pickerPtr->moves.count) {
+                    pickNextMove(&pickerPtr->moves, pickerPtr->scores, pickerPtr->next);
+                    Move move = pickerPtr->moves.moves[pickerPtr->next++];
+                    if(move != pickerPtr->hashMove)
+                        return move;
+                }
+                pickerPtr->stage = PICK_KILLERS;
+                break;
+
+            case PICK_KILLERS:
+                while(pickerPtr->killerIndex < NUM_KILLERS) {
+                    Move killer = pickerPtr->killers[pickerPtr->killerIndex++];
+                    if(killer != NO_MOVE && killer != pickerPtr->hashMove && 
+                       isQuietMove(gamePtr, killer) && moveIsLegal(gamePtr, killer))
+                        return killer;
+                }
+                pickerPtr->stage = GENERATE_QUIETS;
+                break;
+
+            case GENERATE_QUIETS:
+                getLegalMovesOfKind(gamePtr, &pickerPtr->moves, gamePtr->turn, 
+                                    QUIET_MOVES, &pickerPtr->info);
+                pickerPtr->next = 0;
+                pickerPtr->stage = PICK_QUIETS;
+                break;
+
+            case PICK_QUIETS:
+                while(pickerPtr->next < pickerPtr->moves.count) {
+                    Move move = pickerPtr->moves.moves[pickerPtr->next++];
+                    if(move != pickerPtr->hashMove && move != pickerPtr->killers[0] && 
+                       move != pickerPtr->killers[1])
+                        return move;
+                }
+                pickerPtr->stage = PICK_DONE;
+                break;
+
+            default:
+                return NO_MOVE;
+        }
+    }
+}
+
+/*
+ * remembers a quiet move that cut off at ply, for its siblings to try early
+ */
+void storeKiller(SearchState *searchPtr, int ply, Move move) {
+    Move *killers = searchPtr->killers[ply];
+    if(killers[0] == move)
+        return;
+
+    for(int i = NUM_KILLERS - 1; i > 0; i--)
+        killers[i] = killers[i - 1];
+    killers[0] = move;
+}
+
+/*
+ * mate scores count plies from the root, but a stored position may be
+ * reached at any ply: the table keeps them counted from the position itself
+ */
+int scoreToTable(int score, int ply) {
+    if(score >= MATE_SCORE - MAX_SEARCH_DEPTH)
+        return score + ply;
+    if(score <= -MATE_SCORE + MAX_SEARCH_DEPTH)
+        return score - ply;
+    return score;
+}
+
+int scoreFromTable(int score, int ply) {
+    if(score >= MATE_SCORE - MAX_SEARCH_DEPTH)
+        return score - ply;
+    if(score <= -MATE_SCORE + MAX_SEARCH_DEPTH)
+        return score + ply;
+    return score;
+}
+
+/*
+ * quiesce:
+ * searches only the captures and promotions of gamePtr (ply plies from
+ * the root) until the position is quiet, so a leaf is not scored in the
+ * middle of an exchange. the side to move may "stand pat" on the static
+ * evaluation instead of capturing, unless it is in check, when every
+ * evasion is searched (and having none is mate).
+ * returns the score of the position for the side to move,
+ * or 0 if the search was stopped.
+ */
+int quiesce(GameState *gamePtr, SearchState *searchPtr, int ply, int alpha, int beta) {
+    searchPtr->nodes++;
+    if(searchShouldStop(searchPtr)) {
+        searchPtr->stopped = TRUE;
+        return 0;
+    }
+
+    CheckInfo info;
+    findCheckInfo(gamePtr, gamePtr->turn, &info);
+
+    if(!info.checkers) {
+        int standPat = evaluate(gamePtr);
+        if(standPat >= beta)
+            return standPat;
+        if(standPat > alpha)
+            alpha = standPat;
+    }
+
+    if(ply >= MAX_SEARCH_DEPTH - 1)
+        return evaluate(gamePtr);
+
+    MoveList moves;
+    int scores[MAX_MOVES];
+    if(info.checkers) {
+        getLegalMovesOfKind(gamePtr, &moves, gamePtr->turn, ALL_MOVES, &info);
+        if(moves.count == 0)
+            return -MATE_SCORE + ply;
+    } else {
+        getLegalCaptures(gamePtr, &moves, gamePtr->turn, &info);
+    }
+    scoreMoves(gamePtr, &moves, scores);
+
+    for(int i = 0; i < moves.count; i++) {
+        pickNextMove(&moves, scores, i);
+        Move move = moves.moves[i];
+
+        /* underpromotions only matter when they give (or escape) mate */
+        if(!info.checkers && MOVE_IS_PROMOTION(move) && 
+           MOVE_PROMOTION_TYPE(move) != QUEEN)
+            continue;
+
+        UndoInfo undo;
+        makeMove(gamePtr, move, &undo);
+        int score = -quiesce(gamePtr, searchPtr, ply + 1, -beta, -alpha);
+        unmakeMove(gamePtr, move, &undo);
+
+        if(searchPtr->stopped)
+            return 0;
+
+        if(score > alpha) {
+            alpha = score;
+            if(alpha >= beta)
+                break;
+        }
+    }
+
+    return alpha;
+}
+
+/*
+ * negamax:
+ * alpha-beta search of gamePtr, depth plies deep (ply plies from the root),
+ * then quiesce at the leaves.
+ * returns the score of the position for the side to move,
+ * or 0 if the search was stopped.
+ */
+int negamax(GameState *gamePtr, SearchState *searchPtr, int depth, int ply, 
+            int alpha, int beta) {
+    /* a repetition is a draw: going around again can only give the same score */
+    if(ply > 0 && repetitionCount(&searchPtr->history, gamePtr) > 0)
+        return 0;
+
+    /* the fifty-move rule (though mate on the last move still counts) */
+    if(ply > 0 && gamePtr->halfmoveClock >= 100) {
+        int status = gameStatus(gamePtr, NULL);
+        return (status == WHITE_CHECKMATE || status == BLACK_CHECKMATE) ? 
+               -MATE_SCORE + ply : 0;
+    }
+
+    /* leaves are scored once the captures have been played out */
+    if(depth == 0)
+        return quiesce(gamePtr, searchPtr, ply, alpha, beta);
+
+    searchPtr->nodes++;
+    if(searchShouldStop(searchPtr)) {
+        searchPtr->stopped = TRUE;
+        return 0;
+    }
+
+    /* a deep enough earlier result settles the node; any result gives a move to try */
+    TranspositionTable *ttPtr = searchPtr->ttPtr;
+    Move hashMove = NO_MOVE;
+    int ttDepth, ttScore, ttBound;
+    if(ttPtr != NULL && 
+       probeSearchEntry(ttPtr, gamePtr->hash, &ttDepth, &ttScore, &ttBound, &hashMove) && 
+       ply > 0 && ttDepth >= depth) {
+        ttScore = scoreFromTable(ttScore, ply);
+        if(ttBound == EXACT_SCORE || (ttBound == LOWER_BOUND && ttScore >= beta) ||
+           (ttBound == UPPER_BOUND && ttScore <= alpha))
+            return ttScore;
+    }
+    if(ply == 0 && searchPtr->rootBestMove != NO_MOVE)
+        hashMove = searchPtr->rootBestMove;
+
+    MovePicker picker;
+    initMovePicker(&picker, gamePtr, hashMove, searchPtr->killers[ply]);
+
+    int originalAlpha = alpha;
+    Move bestMove = NO_MOVE;
+    int numMoves = 0;
+    Move move;
+    while((move = nextMove(&picker)) != NO_MOVE) {
+        numMoves++;
+
+        UndoInfo undo;
+        makeMove(gamePtr, move, &undo);
+        pushPosition(&searchPtr->history, gamePtr->hash);
+
+        int score = -negamax(gamePtr, searchPtr, depth - 1, ply + 1, -beta, -alpha);
+
+        popPosition(&searchPtr->history);
+        unmakeMove(gamePtr, move, &undo);
+
+        if(searchPtr->stopped)
+            return 0;
+
+        if(score > alpha) {
+            alpha = score;
+            bestMove = move;
+            if(ply == 0)
+                searchPtr->rootBestMove = move;
+            if(alpha >= beta) {
+                /* the opponent will avoid this position */
+                if(isQuietMove(gamePtr, move))
+                    storeKiller(searchPtr, ply, move);
+                break;
+            }
+        }
+    }
+
+    if(numMoves == 0) {
+        /* checkmate (prefer the quickest mate), or stalemate */
+        return picker.info.checkers ? -MATE_SCORE + ply : 0;
+    }
+
+    if(ttPtr != NULL) {
+        int bound = (alpha >= beta) ? LOWER_BOUND : 
+                    (alpha > originalAlpha) ? EXACT_SCORE : UPPER_BOUND;
+        storeSearchEntry(ttPtr, gamePtr->hash, depth, scoreToTable(alpha, ply), 
+                         bound, bestMove);
+    }
+
+    return alpha;
+}
+
+/*
+ * search best move:
+ * finds the best move for the side to move in gamePtr with iterative
+ * deepening: depth 1, 2, ... are searched until a limit in limitsPtr
+ * runs out (or MAX_SEARCH_DEPTH is reached, whatever maxDepth asks for),
+ * each one trying the previous iteration's best move first.
+ * the result of the deepest completed iteration is used.
+ *
+ * ttPtr (if not NULL) keeps what each node found, for the iterations
+ * and later searches to reuse: cutoffs, and the best move to try first.
+ * each search is a new generation of it (see newTableGeneration).
+ *
+ * historyPtr (if not NULL) holds the positions played before gamePtr
+ * (the last one pushed being gamePtr), so lines that repeat them are
+ * scored as draws; without it, only repetitions within the search are.
+ *
+ * resultPtr (if not NULL) receives the score, depth and node count,
+ * and limitsPtr->onIteration (if not NULL) is called after each iteration.
+ *
+ * returns:
+ * the best move, or NO_MOVE if there are no legal moves
+ */
+Move searchBestMove(GameState *gamePtr, PositionHistory *historyPtr,
+                    TranspositionTable *ttPtr, SearchLimits *limitsPtr, 
+                    SearchResult *resultPtr) {
+    SearchState search;
+    search.limitsPtr = limitsPtr;
+    search.startSeconds = wallClockSeconds();
+    search.nodes = 0;
+    search.stopped = FALSE;
+    search.rootBestMove = NO_MOVE;
+    search.ttPtr = ttPtr;
+    if(ttPtr != NULL)
+        newTableGeneration(ttPtr);
+    memset(search.killers, 0, sizeof(search.killers));
+    if(historyPtr != NULL) {
+        search.history = *historyPtr;
+    } else {
+        initHistory(&search.history, gamePtr);
+    }
+
+    SearchResult result;
+    result.bestMove = NO_MOVE;
+    result.score = 0;
+    result.depth = 0;
+
+    /* any legal move beats none, if even depth 1 runs out of time */
+    MoveList rootMoves;
+    if(getAllLegalMoves(gamePtr, &rootMoves, gamePtr->turn) > 0)
+        result.bestMove = rootMoves.moves[0];
+
+    /* the killers (and mate scores) only have room for MAX_SEARCH_DEPTH plies */
+    int maxDepth = limitsPtr->maxDepth > 0 ? limitsPtr->maxDepth : MAX_SEARCH_DEPTH;
+    if(maxDepth > MAX_SEARCH_DEPTH)
+        maxDepth = MAX_SEARCH_DEPTH;
+    for(int depth = 1; depth <= maxDepth && rootMoves.count > 0; depth++) {
+        long long nodesBefore = search.nodes;
+        int score = negamax(gamePtr, &search, depth, 0, -INFINITE_SCORE, 
+                            INFINITE_SCORE);
+        if(search.stopped)
+            break;
+
+        result.bestMove = search.rootBestMove;
+        result.score = score;
+        result.depth = depth;
+        result.nodes = search.nodes;
+        result.iterationNodes = search.nodes - nodesBefore;
+        result.seconds = wallClockSeconds() - search.startSeconds;
+        if(limitsPtr->onIteration)
+            limitsPtr->onIteration(&result);
+
+        /* a forced mate will not get any better */
+        if(abs(score) >= MATE_SCORE - MAX_SEARCH_DEPTH)
+            break;
+    }
+
+    result.nodes = search.nodes;
+    result.seconds = wallClockSeconds() - search.startSeconds;
+    if(resultPtr)
+        *resultPtr = result;
+
+    return result.bestMove;
+}
@@ -0,0 +1,447 @@
+#ifdef _WIN32
+#include <winsock2.h> /* before windows.h (in core.h) */
+#include <afunix.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#endif
+#include <stdarg.h>
+
+#include "core.h"
+
+#ifdef _WIN32
+typedef SOCKET Socket;
+#define poll WSAPoll
+#define closeSocket closesocket
+#else
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closeSocket close
+#endif
+
+#define DEFAULT_SOCKET_PATH "chess.sock"
+#define MAX_REQUEST_LENGTH 256 /* "new <fen>" is the longest request */
+#define MAX_REPLY_LENGTH 2048 /* "ok <move> <move>..." for every legal move */
+#define MAX_UNSENT_REPLIES (1024 * 1024) /* past this, a client's requests wait */
+#define LISTEN_BACKLOG 128
+
+/*
+ * a connection, and its requests and replies in flight
+ */
+typedef struct _client {
+    char request[MAX_REQUEST_LENGTH]; /* the line received so far */
+    int requestLength;
+    int overlong; /* the line outgrew request, and is being skipped */
+
+    TextBuffer replies;
+    long long repliesSent; /* bytes of replies already sent */
+} Client;
+
+/*
+ * the server: every game, and every connection.
+ * one thread waits on all of the sockets at once (poll), and serves
+ * whichever are ready, so a game costs only its slot in the pool.
+ */
+typedef struct _server {
+    GamePool pool;
+
+    struct pollfd *pollFds; /* [0] listens; [i] is clients[i]'s connection */
+    Client *clients; /* clients[0] is not used */
+    int numFds;
+    int fdCapacity;
+} Server;
+
+/*
+ * puts a socket into non-blocking mode.
+ * returns FALSE if it could not.
+ */
+int setNonBlocking(Socket socketFd) {
+#ifdef _WIN32
+    u_long enabled = 1;
+    return ioctlsocket(socketFd, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl(socketFd, F_GETFL, 0);
+    return flags >= 0 && fcntl(socketFd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/*
+ * did the last socket call fail only because it would have blocked?
+ */
+int socketWouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/*
+ * creates a non-blocking socket listening at path
+ * (replacing any socket file left there by an earlier server).
+ *
+ * returns:
+ * the socket, or INVALID_SOCKET if it could not be created
+ */
+Socket openListener(const char *path) {
+    struct sockaddr_un address;
+    if(strlen(path) >= sizeof(address.sun_path))
+        return INVALID_SOCKET;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    Socket listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener == INVALID_SOCKET)
+        return INVALID_SOCKET;
+
+    remove(path);
+    if(bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+       listen(listener, LISTEN_BACKLOG) != 0 || !setNonBlocking(listener)) {
+        closeSocket(listener);
+        return INVALID_SOCKET;
+    }
+    return listener;
+}
+
+/*
+ * adds a connection to the sockets being polled
+ */
+void addClient(Server *serverPtr, Socket clientFd) {
+    if(serverPtr->numFds == serverPtr->fdCapacity) {
+        serverPtr->fdCapacity *= 2;
+        serverPtr->pollFds = realloc(serverPtr->pollFds,
+                                     serverPtr->fdCapacity * sizeof(struct pollfd));
+        serverPtr->clients = realloc(serverPtr->clients,
+                                     serverPtr->fdCapacity * sizeof(Client));
+    }
+
+    int index = serverPtr->numFds++;
+    serverPtr->pollFds[index].fd = clientFd;
+    serverPtr->pollFds[index].events = POLLIN;
+    serverPtr->pollFds[index].revents = 0;
+
+    Client *clientPtr = &serverPtr->clients[index];
+    clientPtr->requestLength = 0;
+    clientPtr->overlong = FALSE;
+    clientPtr->replies.text = NULL;
+    clientPtr->replies.length = 0;
+    clientPtr->replies.capacity = 0;
+    clientPtr->repliesSent = 0;
+}
+
+/*
+ * closes a connection (its games play on, for any other client).
+ * the last connection takes its index.
+ */
+void removeClient(Server *serverPtr, int index) {
+    closeSocket(serverPtr->pollFds[index].fd);
+    free(serverPtr->clients[index].replies.text);
+
+    int last = --serverPtr->numFds;
+    serverPtr->pollFds[index] = serverPtr->pollFds[last];
+    serverPtr->clients[index] = serverPtr->clients[last];
+}
+
+/*
+ * queues a line (printf style) to be sent to a client
+ */
+void reply(Client *clientPtr, const char *format, ...) {
+    char line[MAX_REPLY_LENGTH];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+
+    if(length < 0)
+        return;
+    if(length > sizeof(line) - 2)
+        length = sizeof(line) - 2;
+    line[length++] = '\n';
+    appendText(&clientPtr->replies, line, length);
+}
+
+/*
+ * finds the game named by the id argument of a request.
+ * returns NULL (and replies with an error) if there is no such game.
+ */
+PooledGame *requestedGame(Server *serverPtr, Client *clientPtr, char *idStr) {
+    char *end;
+    long long id = (idStr != NULL) ? strtoll(idStr, &end, 10) : -1;
+    PooledGame *pooledPtr = (idStr != NULL && *end == '\0') ?
+                            poolGame(&serverPtr->pool, id) : NULL;
+
+    if(pooledPtr == NULL)
+        reply(clientPtr, "error no game %s", idStr != NULL ? idStr : "");
+    return pooledPtr;
+}
+
+/*
+ * serves one request (a line, without its '\n'), replying with one line:
+ *     new [fen]           ok <id>
+ *     move <id> <move>    ok <move> <status>    (the move as e2e4 or as SAN)
+ *     status <id>         ok <white|black to move> <moves played> <status>
+ *     fen <id>            ok <fen>
+ *     moves <id>          ok <legal moves...>
+ *     end <id>            ok
+ *     stats               ok <games> games <clients> clients
+ * or with "error <reason>" (E.G. "error game over <status>" for a move
+ * in a game that has ended).
+ */
+void handleRequest(Server *serverPtr, Client *clientPtr, char *line) {
+    char *command = strtok(line, " \t\r");
+    if(command == NULL)
+        return; /* blank lines get no reply */
+
+    if(strcmp(command, "new") == 0) {
+        char *fen = strtok(NULL, "\r");
+        while(fen != NULL && (*fen == ' ' || *fen == '\t'))
+            fen++;
+        if(fen == NULL || *fen == '\0')
+            fen = STARTING_FEN;
+
+        long long id = newPoolGame(&serverPtr->pool, fen);
+        if(id < 0) {
+            reply(clientPtr, "error invalid fen");
+        } else {
+            reply(clientPtr, "ok %lld", id);
+        }
+        return;
+    }
+
+    if(strcmp(command, "stats") == 0) {
+        reply(clientPtr, "ok %d games %d clients",
+              serverPtr->pool.numGames, serverPtr->numFds - 1);
+        return;
+    }
+
+    int isMove = strcmp(command, "move") == 0;
+    if(!isMove && strcmp(command, "status") != 0 && strcmp(command, "fen") != 0 &&
+       strcmp(command, "moves") != 0 && strcmp(command, "end") != 0) {
+        reply(clientPtr, "error unknown command %s", command);
+        return;
+    }
+
+    char *idStr = strtok(NULL, " \t\r");
+    char *moveStr = isMove ? strtok(NULL, " \t\r") : NULL;
+    PooledGame *pooledPtr = requestedGame(serverPtr, clientPtr, idStr);
+    if(pooledPtr == NULL)
+        return;
+    GameState *gamePtr = &pooledPtr->position;
+
+    if(isMove) {
+        if(moveStr == NULL) {
+            reply(clientPtr, "error no move");
+            return;
+        }
+
+        /* a finished game takes no more moves */
+        int status = gameStatus(gamePtr, &pooledPtr->history);
+        if(status != CONTINUE) {
+            reply(clientPtr, "error game over %s", statusName(status));
+            return;
+        }
+
+        Move move = parseUciMove(gamePtr, moveStr);
+        if(move == NO_MOVE)
+            move = parseSan(gamePtr, moveStr, strlen(moveStr));
+        if(move == NO_MOVE) {
+            reply(clientPtr, "error illegal move %s", moveStr);
+            return;
+        }
+
+        makeMove(gamePtr, move, NULL);
+        pushPosition(&pooledPtr->history, gamePtr->hash);
+        pooledPtr->numMoves++;
+
+        char playedStr[6];
+        moveToString(move, playedStr);
+        reply(clientPtr, "ok %s %s", playedStr,
+              statusName(gameStatus(gamePtr, &pooledPtr->history)));
+    } else if(strcmp(command, "status") == 0) {
+        reply(clientPtr, "ok %s %d %s", gamePtr->turn == WHITE ? "white" : "black",
+              pooledPtr->numMoves, statusName(gameStatus(gamePtr, &pooledPtr->history)));
+    } else if(strcmp(command, "fen") == 0) {
+        char fen[MAX_FEN_LENGTH];
+        writeFen(gamePtr, fen);
+        reply(clientPtr, "ok %s", fen);
+    } else if(strcmp(command, "moves") == 0) {
+        MoveList legalMoves;
+        int numMoves = getAllLegalMoves(gamePtr, &legalMoves, gamePtr->turn);
+
+        char movesStr[MAX_MOVES * 6 + 1] = "";
+        int length = 0;
+        for(int i = 0; i < numMoves; i++) {
+            movesStr[length++] = ' ';
+            moveToString(legalMoves.moves[i], movesStr + length);
+            length += strlen(movesStr + length);
+        }
+        reply(clientPtr, "ok%s", movesStr);
+    } else {
+        endPoolGame(&serverPtr->pool, strtoll(idStr, NULL, 10));
+        reply(clientPtr, "ok");
+    }
+}
+
+/*
+ * reads what a client has sent, and serves each complete line.
+ * returns FALSE if the client has disconnected.
+ */
+int receiveRequests(Server *serverPtr, int index) {
+    char data[4096];
+    int received = recv(serverPtr->pollFds[index].fd, data, sizeof(data), 0);
+    if(received == 0)
+        return FALSE;
+    if(received < 0)
+        return socketWouldBlock();
+
+    for(int i = 0; i < received; i++) {
+        /* the server's arrays may move while serving, so look the client up each time */
+        Client *clientPtr = &serverPtr->clients[index];
+
+        if(data[i] == '\n') {
+            if(clientPtr->overlong) {
+                reply(clientPtr, "error request too long");
+            } else {
+                clientPtr->request[clientPtr->requestLength] = '\0';
+                handleRequest(serverPtr, clientPtr, clientPtr->request);
+            }
+            clientPtr->requestLength = 0;
+            clientPtr->overlong = FALSE;
+        } else if(clientPtr->requestLength < MAX_REQUEST_LENGTH - 1) {
+            clientPtr->request[clientPtr->requestLength++] = data[i];
+        } else {
+            clientPtr->overlong = TRUE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * sends as much of a client's queued replies as the socket will take.
+ * returns FALSE if the client has disconnected.
+ */
+int sendReplies(Server *serverPtr, int index) {
+    Client *clientPtr = &serverPtr->clients[index];
+
+    while(clientPtr->repliesSent < clientPtr->replies.length) {
+        long long unsent = clientPtr->replies.length - clientPtr->repliesSent;
+        int sent = send(serverPtr->pollFds[index].fd,
+                        clientPtr->replies.text + clientPtr->repliesSent,
+                        unsent > 65536 ? 65536 : (int) unsent, 0);
+        if(sent < 0)
+            return socketWouldBlock();
+        clientPtr->repliesSent += sent;
+    }
+
+    clientPtr->replies.length = 0;
+    clientPtr->repliesSent = 0;
+    return TRUE;
+}
+
+/*
+ * serves requests until the listening socket fails.
+ * a client with replies waiting is polled for writing, and one that has
+ * let MAX_UNSENT_REPLIES pile up is not read from until it catches up.
+ */
+void runServer(Server *serverPtr, Socket listener) {
+    serverPtr->pollFds[0].fd = listener;
+    serverPtr->pollFds[0].events = POLLIN;
+    serverPtr->numFds = 1;
+
+    while(TRUE) {
+        for(int i = 1; i < serverPtr->numFds; i++) {
+            Client *clientPtr = &serverPtr->clients[i];
+            long long unsent = clientPtr->replies.length - clientPtr->repliesSent;
+            serverPtr->pollFds[i].events = (unsent < MAX_UNSENT_REPLIES ? POLLIN : 0) |
+                                           (unsent > 0 ? POLLOUT : 0);
+        }
+
+        if(poll(serverPtr->pollFds, serverPtr->numFds, -1) < 0) {
+            if(socketWouldBlock())
+                continue;
+            return;
+        }
+
+        /* clients first: new ones join the end of the arrays */
+        for(int i = serverPtr->numFds - 1; i >= 1; i--) {
+            int events = serverPtr->pollFds[i].revents;
+            int connected = TRUE;
+
+            if(events & POLLIN)
+                connected = receiveRequests(serverPtr, i);
+            else if(events & (POLLERR | POLLHUP | POLLNVAL))
+                connected = FALSE;
+
+            /* try to answer at once, rather than on the next poll */
+            if(connected)
+                connected = sendReplies(serverPtr, i);
+
+            if(!connected)
+                removeClient(serverPtr, i);
+        }
+
+        if(serverPtr->pollFds[0].revents & POLLIN) {
+            Socket clientFd;
+            while((clientFd = accept(listener, NULL, NULL)) != INVALID_SOCKET) {
+                if(setNonBlocking(clientFd)) {
+                    addClient(serverPtr, clientFd);
+                } else {
+                    closeSocket(clientFd);
+                }
+            }
+        } else if(serverPtr->pollFds[0].revents & (POLLERR | POLLNVAL)) {
+            return;
+        }
+    }
+}
+
+/*
+ * usage:
+ *     server [socket]
+ * hosts games for any number of clients, on a local (Unix domain) socket
+ * at the path socket (default: chess.sock). requests and replies are
+ * lines of text (see handleRequest); any client may move in any game.
+ */
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : DEFAULT_SOCKET_PATH;
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        printf("could not start winsock\n");
+        return 1;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN); /* a client that hangs up is seen by send instead */
+#endif
+
+    initEvalTables();
+
+    Socket listener = openListener(path);
+    if(listener == INVALID_SOCKET) {
+        printf("could not listen at %s\n", path);
+        return 1;
+    }
+    printf("listening at %s\n", path);
+    fflush(stdout);
+
+    Server server;
+    initGamePool(&server.pool);
+    server.fdCapacity = 64;
+    server.pollFds = malloc(server.fdCapacity * sizeof(struct pollfd));
+    server.clients = malloc(server.fdCapacity * sizeof(Client));
+
+    runServer(&server, listener);
+
+    printf("stopped listening at %s\n", path);
+    closeSocket(listener);
+    remove(path);
+    freeGamePool(&server.pool);
+    return 1;
+}
@@ -0,0 +1,172 @@
+#include "core.h"
+
+/*
+ * a thread's entry point and argument, passed through the
+ * platform's thread start function
+ */
+typedef struct _threadStart {
+    void (*function)(void *);
+    void *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+
+/*
+ * calls the thread's function (windows entry point)
+ */
+DWORD WINAPI runThread(LPVOID startPtr) {
+    ThreadStart start = *(ThreadStart *) startPtr;
+    free(startPtr);
+
+    start.function(start.arg);
+    return 0;
+}
+
+#else
+
+/*
+ * calls the thread's function (pthreads entry point)
+ */
+void *runThread(void *startPtr) {
+    ThreadStart start = *(ThreadStart *) startPtr;
+    free(startPtr);
+
+    start.function(start.arg);
+    return NULL;
+}
+
+#endif
+
+/*
+ * starts a thread running function(arg).
+ *
+ * returns:
+ * FALSE if the thread could not be started
+ */
+int startThread(Thread *threadPtr, void (*function)(void *), void *arg) {
+    ThreadStart *startPtr = malloc(sizeof(ThreadStart));
+    startPtr->function = function;
+    startPtr->arg = arg;
+
+#ifdef _WIN32
+    *threadPtr = CreateThread(NULL, 0, runThread, startPtr, 0, NULL);
+    if(*threadPtr == NULL) {
+#else
+    if(pthread_create(threadPtr, NULL, runThread, startPtr) != 0) {
+#endif
+        free(startPtr);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * waits for a thread to finish
+ */
+void joinThread(Thread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+/*
+ * mutexes: thin wrappers over the platform's locks
+ */
+void initMutex(Mutex *mutexPtr) {
+#ifdef _WIN32
+    InitializeCriticalSection(mutexPtr);
+#else
+    pthread_mutex_init(mutexPtr, NULL);
+#endif
+}
+
+void lockMutex(Mutex *mutexPtr) {
+#ifdef _WIN32
+    EnterCriticalSection(mutexPtr);
+#else
+    pthread_mutex_lock(mutexPtr);
+#endif
+}
+
+void unlockMutex(Mutex *mutexPtr) {
+#ifdef _WIN32
+    LeaveCriticalSection(mutexPtr);
+#else
+    pthread_mutex_unlock(mutexPtr);
+#endif
+}
+
+void destroyMutex(Mutex *mutexPtr) {
+#ifdef _WIN32
+    DeleteCriticalSection(mutexPtr);
+#else
+    pthread_mutex_destroy(mutexPtr);
+#endif
+}
+
+/*
+ * condition variables, waited on while holding a Mutex
+ */
+void initCondition(Condition *conditionPtr) {
+#ifdef _WIN32
+    InitializeConditionVariable(conditionPtr);
+#else
+    pthread_cond_init(conditionPtr, NULL);
+#endif
+}
+
+/* unlocks mutexPtr until the condition is signalled, then relocks it */
+void waitCondition(Condition *conditionPtr, Mutex *mutexPtr) {
+#ifdef _WIN32
+    SleepConditionVariableCS(conditionPtr, mutexPtr, INFINITE);
+#else
+    pthread_cond_wait(conditionPtr, mutexPtr);
+#endif
+}
+
+/* wakes every thread waiting on the condition */
+void broadcastCondition(Condition *conditionPtr) {
+#ifdef _WIN32
+    WakeAllConditionVariable(conditionPtr);
+#else
+    pthread_cond_broadcast(conditionPtr);
+#endif
+}
+
+void destroyCondition(Condition *conditionPtr) {
+#ifndef _WIN32
+    pthread_cond_destroy(conditionPtr); /* windows has nothing to free */
+#endif
+}
+
+/*
+ * the number of processors threads can run on
+ */
+int processorCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? count : 1;
+#endif
+}
+
+/*
+ * seconds since some fixed point, measured by the wall clock
+ * (unlike clock(), which adds up the time of every thread)
+ */
+double wallClockSeconds() {
+#ifdef _WIN32
+    return GetTickCount64() / 1000.0;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
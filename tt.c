@@ -0,0 +1,162 @@
+#include "core.h"
+
+/*
+ * entries are stored as (key ^ data, data): an entry only matches if
+ * both words were written by the same store, so threads can read the
+ * table without locks and simply miss on a half-written entry.
+ *
+ * for perft, data packs the node count (upper 56 bits) and depth (lower 8 bits).
+ * for a search, it packs the depth (lower 8 bits, as for perft so entries
+ * are replaced the same way), the bound (next 8), the score (next 16,
+ * signed), the best move (next 16) and the generation of the search that
+ * stored it (next 8). a table holds one kind or the other.
+ */
+#define DATA_DEPTH(data) ((int) ((data) & 0xFF))
+#define DATA_NODES(data) ((long long) ((data) >> 8))
+#define PACK_DATA(depth, nodes) (((unsigned long long) (nodes) << 8) | (depth))
+
+#define DATA_BOUND(data) ((int) (((data) >> 8) & 0xFF))
+#define DATA_SCORE(data) ((int) (short) (((data) >> 16) & 0xFFFF))
+#define DATA_MOVE(data) ((Move) (((data) >> 32) & 0xFFFF))
+#define DATA_GENERATION(data) ((int) (((data) >> 48) & 0xFF))
+#define PACK_SEARCH_DATA(depth, bound, score, move, generation) \
+    ((unsigned long long) (depth) | ((unsigned long long) (bound) << 8) | \
+     ((unsigned long long) ((score) & 0xFFFF) << 16) | ((unsigned long long) (move) << 32) | \
+     ((unsigned long long) ((generation) & 0xFF) << 48))
+
+/*
+ * allocates a table of (at most) megabytes MB.
+ * the number of buckets is rounded down to a power of two,
+ * so a hash maps to a bucket with a mask.
+ *
+ * returns:
+ * FALSE if the table could not be allocated
+ */
+int initTranspositionTable(TranspositionTable *ttPtr, int megabytes) {
+    unsigned long long numBuckets = 1;
+    unsigned long long budget = (unsigned long long) megabytes * 1024 * 1024;
+    while(numBuckets * 2 * sizeof(TTBucket) <= budget)
+        numBuckets *= 2;
+
+    ttPtr->buckets = calloc(numBuckets, sizeof(TTBucket));
+    ttPtr->mask = numBuckets - 1;
+    ttPtr->generation = 0;
+
+    return ttPtr->buckets != NULL;
+}
+
+/*
+ * frees the entries of a table
+ */
+void freeTranspositionTable(TranspositionTable *ttPtr) {
+    free(ttPtr->buckets);
+    ttPtr->buckets = NULL;
+}
+
+/*
+ * empties every entry of a table
+ */
+void clearTranspositionTable(TranspositionTable *ttPtr) {
+    memset(ttPtr->buckets, 0, (ttPtr->mask + 1) * sizeof(TTBucket));
+}
+
+/*
+ * starts a new search generation: entries stored by earlier searches
+ * (of earlier positions) give way to new ones, however deep they were
+ */
+void newTableGeneration(TranspositionTable *ttPtr) {
+    ttPtr->generation = (ttPtr->generation + 1) & 0xFF;
+}
+
+/*
+ * looks up the node count stored for hash at depth.
+ *
+ * returns:
+ * TRUE (and sets *nodesPtr) if it was found
+ */
+int probeNodeCount(TranspositionTable *ttPtr, unsigned long long hash, int depth, 
+                   long long *nodesPtr) {
+    TTBucket *bucketPtr = &ttPtr->buckets[hash & ttPtr->mask];
+
+    for(int i = 0; i < TT_BUCKET_SIZE; i++) {
+        unsigned long long data = bucketPtr->entries[i].data;
+        if((bucketPtr->entries[i].check ^ data) == hash && 
+           DATA_DEPTH(data) == depth) {
+            *nodesPtr = DATA_NODES(data);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * stores the node count of hash at depth.
+ * the first entry of a bucket keeps the deepest (most expensive)
+ * result, the second always takes the newest.
+ */
+void storeNodeCount(TranspositionTable *ttPtr, unsigned long long hash, int depth, 
+                    long long nodes) {
+    TTBucket *bucketPtr = &ttPtr->buckets[hash & ttPtr->mask];
+    unsigned long long data = PACK_DATA(depth, nodes);
+
+    TTEntry *entryPtr = &bucketPtr->entries[1];
+    if(depth >= DATA_DEPTH(bucketPtr->entries[0].data))
+        entryPtr = &bucketPtr->entries[0];
+
+    entryPtr->check = hash ^ data;
+    entryPtr->data = data;
+}
+
+/*
+ * looks up the search result stored for hash.
+ *
+ * returns:
+ * TRUE (and sets the depth searched, score, bound and best move) if it was found
+ */
+int probeSearchEntry(TranspositionTable *ttPtr, unsigned long long hash, int *depthPtr,
+                     int *scorePtr, int *boundPtr, Move *movePtr) {
+    TTBucket *bucketPtr = &ttPtr->buckets[hash & ttPtr->mask];
+
+    for(int i = 0; i < TT_BUCKET_SIZE; i++) {
+        unsigned long long data = bucketPtr->entries[i].data;
+        if((bucketPtr->entries[i].check ^ data) == hash && DATA_BOUND(data) != 0) {
+            *depthPtr = DATA_DEPTH(data);
+            *scorePtr = DATA_SCORE(data);
+            *boundPtr = DATA_BOUND(data);
+            *movePtr = DATA_MOVE(data);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * stores the result of searching hash depth plies deep: its score,
+ * which bound (EXACT_SCORE, LOWER_BOUND or UPPER_BOUND) that is,
+ * and the best move (NO_MOVE if none was found, when the move already
+ * stored for hash is kept, for the move picker to try first).
+ * entries are replaced as in storeNodeCount, except that the first
+ * entry also gives way when it is from an earlier generation.
+ */
+void storeSearchEntry(TranspositionTable *ttPtr, unsigned long long hash, int depth,
+                      int score, int bound, Move move) {
+    TTBucket *bucketPtr = &ttPtr->buckets[hash & ttPtr->mask];
+
+    for(int i = 0; i < TT_BUCKET_SIZE && move == NO_MOVE; i++) {
+        unsigned long long oldData = bucketPtr->entries[i].data;
+        if((bucketPtr->entries[i].check ^ oldData) == hash && DATA_BOUND(oldData) != 0)
+            move = DATA_MOVE(oldData);
+    }
+    unsigned long long data = PACK_SEARCH_DATA(depth, bound, score, move, 
+                                               ttPtr->generation);
+
+    unsigned long long firstData = bucketPtr->entries[0].data;
+    TTEntry *entryPtr = &bucketPtr->entries[1];
+    if(depth >= DATA_DEPTH(firstData) || DATA_GENERATION(firstData) != ttPtr->generation)
+        entryPtr = &bucketPtr->entries[0];
+
+    entryPtr->check = hash ^ data;
+    entryPtr->data = data;
+}
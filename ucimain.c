@@ -0,0 +1,338 @@
+#include "core.h"
+
+#define MAX_UCI_LINE 65536 /* a position command with a long game's moves */
+#define DEFAULT_MOVES_TO_GO 30 /* time is shared out as if this many moves remain */
+#define SAFETY_SECONDS 0.05 /* kept back from each move's time for overhead */
+#define DEFAULT_HASH_MB 16
+#define MAX_HASH_MB 4096
+
+/*
+ * the engine: the position the GUI set up, and the search running on it.
+ * the main thread reads commands, and one worker thread runs each search,
+ * so commands are answered even while the engine is thinking.
+ */
+typedef struct _uciEngine {
+    GameState position;
+    PositionHistory history; /* of position, from the moves it was given with */
+    TranspositionTable tt; /* kept from search to search (buckets NULL: none) */
+
+    Thread searchThread;
+    int searching; /* searchThread has been started and not yet joined */
+    GameState searchPosition; /* the worker's copy of position */
+    SearchLimits limits;
+    int infinite; /* hold bestmove back until stop (go infinite) */
+
+    volatile int stopRequested; /* limits.stopPtr points here */
+    Mutex lock; /* guards stopRequested for stopped */
+    Condition stopped; /* signalled when stop is requested */
+} UciEngine;
+
+/*
+ * prints info about a completed search iteration, for the GUI
+ * (called on the search thread)
+ */
+void printIteration(SearchResult *resultPtr) {
+    char scoreStr[32];
+    int score = resultPtr->score;
+    if(abs(score) >= MATE_SCORE - MAX_SEARCH_DEPTH) {
+        /* mate in moves, not plies: negative when the engine is getting mated */
+        int matePlies = MATE_SCORE - abs(score);
+        sprintf(scoreStr, "mate %d", score > 0 ? (matePlies + 1) / 2 : -(matePlies / 2));
+    } else {
+        sprintf(scoreStr, "cp %d", score);
+    }
+
+    char moveStr[6];
+    moveToString(resultPtr->bestMove, moveStr);
+
+    int milliseconds = (int) (resultPtr->seconds * 1000);
+    long long nodesPerSecond = resultPtr->seconds > 0 ?
+                               (long long) (resultPtr->nodes / resultPtr->seconds) : 0;
+
+    /* one printf per line, so lines from the two threads never interleave */
+    printf("info depth %d score %s nodes %lld nps %lld time %d pv %s\n",
+           resultPtr->depth, scoreStr, resultPtr->nodes, nodesPerSecond,
+           milliseconds, moveStr);
+    fflush(stdout);
+}
+
+/*
+ * search thread:
+ * searches the engine's copy of the position and prints the best move
+ */
+void searchWorker(void *engineArg) {
+    UciEngine *enginePtr = engineArg;
+    TranspositionTable *ttPtr = (enginePtr->tt.buckets != NULL) ? &enginePtr->tt : NULL;
+    Move bestMove = searchBestMove(&enginePtr->searchPosition, &enginePtr->history,
+                                   ttPtr, &enginePtr->limits, NULL);
+
+    /* an infinite search may not answer before it is told to stop */
+    if(enginePtr->infinite) {
+        lockMutex(&enginePtr->lock);
+        while(!enginePtr->stopRequested) {
+            waitCondition(&enginePtr->stopped, &enginePtr->lock);
+        }
+        unlockMutex(&enginePtr->lock);
+    }
+
+    char moveStr[6] = "0000"; /* the UCI null move: there are no legal moves */
+    if(bestMove != NO_MOVE)
+        moveToString(bestMove, moveStr);
+    printf("bestmove %s\n", moveStr);
+    fflush(stdout);
+}
+
+/*
+ * stops the running search (if any), and waits for its bestmove
+ */
+void stopSearch(UciEngine *enginePtr) {
+    if(!enginePtr->searching)
+        return;
+
+    lockMutex(&enginePtr->lock);
+    enginePtr->stopRequested = TRUE;
+    broadcastCondition(&enginePtr->stopped);
+    unlockMutex(&enginePtr->lock);
+
+    joinThread(enginePtr->searchThread);
+    enginePtr->searching = FALSE;
+}
+
+/*
+ * position [startpos | fen <fen>] [moves <move>...]
+ * (the words after "position" are in strtok, one call away)
+ * the position is built aside and only then given to the engine:
+ * if a move is illegal, the engine gets the position before the moves.
+ */
+void setPosition(UciEngine *enginePtr) {
+    GameState game;
+    GameState *gamePtr = &game;
+    PositionHistory history;
+    char *token = strtok(NULL, " \t\n\r");
+
+    if(token != NULL && strcmp(token, "fen") == 0) {
+        /* the fen is every word up to "moves" */
+        char fen[MAX_FEN_LENGTH] = "";
+        while((token = strtok(NULL, " \t\n\r")) != NULL && strcmp(token, "moves") != 0) {
+            if(strlen(fen) + strlen(token) + 1 < sizeof(fen)) {
+                strcat(fen, token);
+                strcat(fen, " ");
+            }
+        }
+        if(!loadFen(gamePtr, fen)) {
+            printf("info string invalid fen: %s\n", fen);
+            loadFen(gamePtr, STARTING_FEN);
+            token = NULL; /* the moves were for the other position */
+        }
+    } else {
+        loadFen(gamePtr, STARTING_FEN);
+        token = strtok(NULL, " \t\n\r");
+    }
+    initHistory(&history, gamePtr);
+
+    if(token != NULL && strcmp(token, "moves") == 0) {
+        GameState basePosition = game;
+
+        while((token = strtok(NULL, " \t\n\r")) != NULL) {
+            Move move = parseUciMove(gamePtr, token);
+            if(move == NO_MOVE) {
+                printf("info string illegal move: %s\n", token);
+                game = basePosition;
+                initHistory(&history, gamePtr);
+                break;
+            }
+            makeMove(gamePtr, move, NULL);
+            pushPosition(&history, gamePtr->hash);
+        }
+    }
+
+    enginePtr->position = game;
+    enginePtr->history = history;
+}
+
+/*
+ * the seconds to spend on a move, given the side to move's clock
+ */
+double allocateSeconds(int timeLeftMs, int incrementMs, int movesToGo) {
+    if(movesToGo <= 0)
+        movesToGo = DEFAULT_MOVES_TO_GO;
+
+    double seconds = (timeLeftMs / (double) movesToGo + incrementMs * 0.75) / 1000;
+    double maxSeconds = timeLeftMs / 1000.0 / 2;
+    if(seconds > maxSeconds)
+        seconds = maxSeconds;
+
+    seconds -= SAFETY_SECONDS;
+    return seconds > 0.001 ? seconds : 0.001;
+}
+
+/*
+ * is token a go keyword that is followed by a value ?
+ * (the others, like infinite and ponder, stand alone)
+ */
+int goKeywordTakesValue(const char *token) {
+    static const char *keywords[] = {"depth", "nodes", "movetime", "wtime", "btime",
+                                     "winc", "binc", "movestogo", "mate"};
+
+    for(int i = 0; i < (int) (sizeof(keywords) / sizeof(keywords[0])); i++) {
+        if(strcmp(token, keywords[i]) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * go [depth <n>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>]
+ *    [winc <ms>] [binc <ms>] [movestogo <n>] [infinite]
+ * starts a search of the current position on the search thread.
+ * other keywords (E.G. ponder) are skipped, along with their values.
+ */
+void startSearch(UciEngine *enginePtr) {
+    SearchLimits *limitsPtr = &enginePtr->limits;
+    int color = enginePtr->position.turn;
+    int timeLeftMs = 0, incrementMs = 0, movesToGo = 0, moveTimeMs = 0;
+    char *token;
+
+    memset(limitsPtr, 0, sizeof(SearchLimits));
+    enginePtr->infinite = FALSE;
+
+    while((token = strtok(NULL, " \t\n\r")) != NULL) {
+        if(strcmp(token, "infinite") == 0) {
+            enginePtr->infinite = TRUE;
+            continue;
+        }
+        if(!goKeywordTakesValue(token))
+            continue;
+
+        char *value = strtok(NULL, " \t\n\r");
+        if(value == NULL)
+            break;
+
+        if(strcmp(token, "depth") == 0) {
+            limitsPtr->maxDepth = atoi(value);
+        } else if(strcmp(token, "nodes") == 0) {
+            limitsPtr->maxNodes = atoll(value);
+        } else if(strcmp(token, "movetime") == 0) {
+            moveTimeMs = atoi(value);
+        } else if(strcmp(token, color == WHITE ? "wtime" : "btime") == 0) {
+            timeLeftMs = atoi(value);
+        } else if(strcmp(token, color == WHITE ? "winc" : "binc") == 0) {
+            incrementMs = atoi(value);
+        } else if(strcmp(token, "movestogo") == 0) {
+            movesToGo = atoi(value);
+        }
+    }
+
+    if(!enginePtr->infinite) {
+        if(moveTimeMs > 0) {
+            limitsPtr->maxSeconds = moveTimeMs / 1000.0;
+        } else if(timeLeftMs > 0) {
+            limitsPtr->maxSeconds = allocateSeconds(timeLeftMs, incrementMs, movesToGo);
+        }
+    }
+
+    limitsPtr->onIteration = printIteration;
+    limitsPtr->stopPtr = &enginePtr->stopRequested;
+    enginePtr->stopRequested = FALSE;
+    enginePtr->searchPosition = enginePtr->position;
+
+    if(!startThread(&enginePtr->searchThread, searchWorker, enginePtr)) {
+        printf("info string could not start the search thread\n");
+        printf("bestmove 0000\n");
+        return;
+    }
+    enginePtr->searching = TRUE;
+}
+
+/*
+ * setoption name <name> [value <value>]
+ * the only option is Hash, the transposition table's size in MB.
+ */
+void setOption(UciEngine *enginePtr) {
+    char *token = strtok(NULL, " \t\n\r");
+    char *name = (token != NULL && strcmp(token, "name") == 0) ? strtok(NULL, " \t\n\r") : NULL;
+    token = strtok(NULL, " \t\n\r");
+    char *value = (token != NULL && strcmp(token, "value") == 0) ? strtok(NULL, " \t\n\r") : NULL;
+
+    if(name == NULL || strcmp(name, "Hash") != 0) {
+        printf("info string unknown option %s\n", name != NULL ? name : "");
+        return;
+    }
+
+    int megabytes = (value != NULL) ? atoi(value) : DEFAULT_HASH_MB;
+    if(megabytes < 1)
+        megabytes = 1;
+    if(megabytes > MAX_HASH_MB)
+        megabytes = MAX_HASH_MB;
+
+    freeTranspositionTable(&enginePtr->tt);
+    if(!initTranspositionTable(&enginePtr->tt, megabytes)) {
+        printf("info string could not allocate %d MB of hash\n", megabytes);
+        enginePtr->tt.buckets = NULL;
+    }
+}
+
+/*
+ * usage:
+ *     uci
+ * speaks the Universal Chess Interface on stdin/stdout:
+ * uci, isready, ucinewgame, setoption, position, go, stop and quit.
+ * commands are read on the main thread while the search runs on its own,
+ * so stop and isready are answered at once, even mid-search.
+ */
+int main() {
+    static char line[MAX_UCI_LINE];
+    UciEngine engine;
+
+    initEvalTables();
+    loadFen(&engine.position, STARTING_FEN);
+    initHistory(&engine.history, &engine.position);
+    engine.searching = FALSE;
+    engine.stopRequested = FALSE;
+    initMutex(&engine.lock);
+    initCondition(&engine.stopped);
+    if(!initTranspositionTable(&engine.tt, DEFAULT_HASH_MB))
+        engine.tt.buckets = NULL;
+
+    while(fgets(line, sizeof(line), stdin) != NULL) {
+        char *command = strtok(line, " \t\n\r");
+        if(command == NULL)
+            continue;
+
+        if(strcmp(command, "uci") == 0) {
+            printf("id name chess\n");
+            printf("id author the chess authors\n");
+            printf("option name Hash type spin default %d min 1 max %d\n", 
+                   DEFAULT_HASH_MB, MAX_HASH_MB);
+            printf("uciok\n");
+        } else if(strcmp(command, "isready") == 0) {
+            printf("readyok\n");
+        } else if(strcmp(command, "setoption") == 0) {
+            stopSearch(&engine);
+            setOption(&engine);
+        } else if(strcmp(command, "ucinewgame") == 0) {
+            stopSearch(&engine);
+            loadFen(&engine.position, STARTING_FEN);
+            initHistory(&engine.history, &engine.position);
+            if(engine.tt.buckets != NULL)
+                clearTranspositionTable(&engine.tt);
+        } else if(strcmp(command, "position") == 0) {
+            stopSearch(&engine);
+            setPosition(&engine);
+        } else if(strcmp(command, "go") == 0) {
+            stopSearch(&engine);
+            startSearch(&engine);
+        } else if(strcmp(command, "stop") == 0) {
+            stopSearch(&engine);
+        } else if(strcmp(command, "quit") == 0) {
+            break;
+        }
+        fflush(stdout);
+    }
+
+    stopSearch(&engine);
+    destroyCondition(&engine.stopped);
+    destroyMutex(&engine.lock);
+    freeTranspositionTable(&engine.tt);
+    return 0;
+}
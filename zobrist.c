@@ -0,0 +1,33 @@
+#include "core.h"
+
+/*
+ * zobrist keys: a position's hash is the xor of one random key
+ * per (piece, square), plus keys for its castling rights,
+ * en passant file, and black to move.
+ * the keys themselves are generated into tables.c by gentables.
+ */
+
+/*
+ * computes the hash of gamePtr from scratch
+ * (moves keep gamePtr->hash up to date incrementally)
+ */
+unsigned long long computeHash(GameState *gamePtr) {
+    unsigned long long hash = 0;
+
+    for(int color = 0; color < 2; color++) {
+        for(int type = 0; type < 6; type++) {
+            Bitboard pieces = gamePtr->pieceBoards[color][type];
+            while(pieces) {
+                hash ^= pieceKeys[color][type][popLowestSquare(&pieces)];
+            }
+        }
+    }
+
+    hash ^= castlingKeys[gamePtr->castlingRights];
+    if(gamePtr->enPassantSquare != NO_SQUARE)
+        hash ^= enPassantKeys[SQUARE_COL(gamePtr->enPassantSquare)];
+    if(gamePtr->turn == BLACK)
+        hash ^= blackToMoveKey;
+
+    return hash;
+}